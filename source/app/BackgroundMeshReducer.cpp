@@ -0,0 +1,179 @@
+#include "BackgroundMeshReducer.h"
+#include "ProgressiveMeshFile.h"
+#include <algorithm>
+#include <exception>
+#include <engine/util/Logger.h>
+
+#ifdef EMSCRIPTEN
+#include <chrono>
+
+namespace
+{
+    // Time per consumeResults() call that the reductions may use on the render thread
+    const std::chrono::microseconds SLICE_BUDGET(8000);
+    // Number of collapses between two time checks
+    const size_t COLLAPSES_PER_TIME_CHECK = 64;
+}
+#endif
+
+BackgroundMeshReducer::~BackgroundMeshReducer()
+{
+#ifndef EMSCRIPTEN
+    {
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        m_cancel = true;
+    }
+
+    m_jobAdded.notify_all();
+    for (auto& worker : m_workers)
+        worker.join();
+#else
+    m_cancel = true;
+#endif
+}
+
+void BackgroundMeshReducer::start(size_t meshIdx, const MeshLoader& loadMesh, const std::string& cachePath, uint64_t sourceStamp)
+{
+    ++m_pendingCount;
+
+#ifdef EMSCRIPTEN
+    m_jobs.push_back(std::make_unique<Job>(meshIdx, loadMesh, cachePath, sourceStamp));
+#else
+    {
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        m_jobs.push_back(std::make_unique<Job>(meshIdx, loadMesh, cachePath, sourceStamp));
+
+        // Workers are only added if the waiting jobs outnumber the idle workers.
+        // Beyond the hardware threads jobs wait for a worker to finish its current one.
+        size_t maxWorkerCount = std::max(size_t(std::thread::hardware_concurrency()), size_t(1));
+        if (m_jobs.size() - m_nextJobIdx > m_idleWorkerCount && m_workers.size() < maxWorkerCount)
+            m_workers.emplace_back([this]() { workerLoop(); });
+    }
+
+    m_jobAdded.notify_one();
+#endif
+}
+
+#ifndef EMSCRIPTEN
+void BackgroundMeshReducer::workerLoop()
+{
+    for (;;)
+    {
+        Job* job = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(m_jobMutex);
+            ++m_idleWorkerCount;
+            m_jobAdded.wait(lock, [this]() { return m_nextJobIdx < m_jobs.size() || m_cancel.load(std::memory_order_relaxed); });
+            --m_idleWorkerCount;
+
+            if (m_cancel.load(std::memory_order_relaxed))
+                return;
+
+            job = m_jobs[m_nextJobIdx++].get();
+        }
+
+        if (reduce(*job, [this]() { return m_cancel.load(std::memory_order_relaxed); }))
+            finish(*job);
+    }
+}
+#endif
+
+float BackgroundMeshReducer::getProgress(size_t meshIdx) const
+{
+    for (auto& job : m_jobs)
+    {
+        if (job->meshIdx != meshIdx)
+            continue;
+
+        if (job->finished.load(std::memory_order_acquire))
+            return 1.0f;
+
+        size_t vertexCount = job->vertexCount.load(std::memory_order_relaxed);
+        if (vertexCount == 0)
+            return 0.0f;
+
+        return std::min(float(job->collapseCount.load(std::memory_order_relaxed)) / float(vertexCount), 1.0f);
+    }
+
+    return 1.0f;
+}
+
+template<class TStopFunc>
+bool BackgroundMeshReducer::reduce(Job& job, TStopFunc shouldStop)
+{
+    if (!job.started)
+    {
+        job.started = true;
+
+        // A failed load finishes the job without a mesh, so the result is still published
+        try
+        {
+            job.originalMesh = job.loadMesh();
+            if (job.originalMesh)
+                job.mesh = *job.originalMesh;
+        }
+        catch (const std::exception& e)
+        {
+            Logger::stream() << "Could not load the mesh of a background reduction: " << e.what() << std::endl;
+            job.originalMesh = nullptr;
+        }
+
+        if (!job.originalMesh)
+            return true;
+
+        job.vertexCount.store(job.originalMesh->getVertices().size(), std::memory_order_relaxed);
+    }
+
+    auto& result = job.result;
+
+    while (!shouldStop())
+    {
+        float error = 0.0f;
+        EdgeID collapsedEdge = job.mesh.reduce(&error);
+        if (collapsedEdge < 0)
+            return true;
+
+        result.collapsedEdges.push_back(collapsedEdge);
+        result.collapseErrors.push_back(error);
+        job.collapseCount.store(result.collapsedEdges.size(), std::memory_order_relaxed);
+    }
+
+    return false;
+}
+
+void BackgroundMeshReducer::finish(Job& job)
+{
+    if (job.originalMesh && !job.cachePath.empty())
+        ProgressiveMeshFile::write(job.cachePath, *job.originalMesh, job.result.collapsedEdges, job.result.collapseErrors, job.sourceStamp);
+
+    job.result.meshIdx = job.meshIdx;
+    job.result.originalMesh = std::move(job.originalMesh);
+
+    // The reduced copy isn't needed anymore
+    job.mesh = ReducibleDirectedEdgeMesh();
+    job.finished.store(true, std::memory_order_release);
+    m_results.push(std::move(job.result));
+}
+
+#ifdef EMSCRIPTEN
+void BackgroundMeshReducer::processSliced()
+{
+    auto deadline = std::chrono::steady_clock::now() + SLICE_BUDGET;
+    size_t collapses = 0;
+    auto shouldStop = [&deadline, &collapses]()
+    {
+        return ++collapses % COLLAPSES_PER_TIME_CHECK == 0 && std::chrono::steady_clock::now() >= deadline;
+    };
+
+    for (auto& job : m_jobs)
+    {
+        if (job->finished)
+            continue;
+
+        if (!reduce(*job, shouldStop))
+            return;
+
+        finish(*job);
+    }
+}
+#endif
@@ -0,0 +1,134 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <string>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include "ReducibleDirectedEdgeMesh.h"
+#include <engine/util/MpscQueue.h>
+
+#ifndef EMSCRIPTEN
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif
+
+struct MeshReductionResult
+{
+    size_t meshIdx{ 0 };
+    // The unreduced mesh built by the loader of the job, null if the loader failed (no collapses then)
+    std::shared_ptr<ReducibleDirectedEdgeMesh> originalMesh;
+    std::vector<EdgeID> collapsedEdges;
+    std::vector<float> collapseErrors;
+};
+
+/**
+* Loads and fully reduces meshes in the background. The jobs are processed in start order by at most one worker
+* thread per hardware thread. A worker builds the mesh with the loader of the job (import, connectivity) and reduces
+* a copy of it, so the calling thread never waits.
+* Finished reductions are written to their progressive mesh file by the worker and handed to the
+* calling thread through a lock-free queue together with the unreduced mesh.
+* Without thread support (emscripten) the reductions are processed in consumeResults() with a time budget per call.
+*/
+class BackgroundMeshReducer
+{
+public:
+    // Builds the unreduced mesh, called on a worker thread. Returns null or throws if the mesh can't be loaded.
+    using MeshLoader = std::function<std::shared_ptr<ReducibleDirectedEdgeMesh>()>;
+
+private:
+    struct Job
+    {
+        Job(size_t meshIdx, const MeshLoader& loadMesh, const std::string& cachePath, uint64_t sourceStamp)
+            :meshIdx(meshIdx), loadMesh(loadMesh), cachePath(cachePath), sourceStamp(sourceStamp) {}
+
+        size_t meshIdx{ 0 };
+        MeshLoader loadMesh;
+        std::shared_ptr<ReducibleDirectedEdgeMesh> originalMesh;
+        // Copy of originalMesh made by the worker, released when the reduction is finished
+        ReducibleDirectedEdgeMesh mesh;
+        std::string cachePath;
+        uint64_t sourceStamp{ 0 };
+        MeshReductionResult result;
+
+        // Published by the worker once the mesh is loaded and after every collapse, read by getProgress()
+        std::atomic<size_t> vertexCount{ 0 };
+        std::atomic<size_t> collapseCount{ 0 };
+        std::atomic<bool> finished{ false };
+        // Set once the worker started to load the mesh
+        bool started{ false };
+    };
+
+public:
+    BackgroundMeshReducer() {}
+    // Cancels the running reductions and waits for the workers
+    ~BackgroundMeshReducer();
+
+    BackgroundMeshReducer(const BackgroundMeshReducer&) = delete;
+    BackgroundMeshReducer& operator=(const BackgroundMeshReducer&) = delete;
+
+    /**
+    * Queues the reduction of the mesh that loadMesh returns. The progressive mesh file is written
+    * to cachePath if it isn't empty (see ProgressiveMeshFile::write).
+    */
+    void start(size_t meshIdx, const MeshLoader& loadMesh, const std::string& cachePath, uint64_t sourceStamp);
+
+    /**
+    * Calls func(MeshReductionResult&) for every reduction that finished since the last call.
+    * Must be called from the thread that calls start(). Returns the number of consumed results.
+    */
+    template<class TFunc>
+    size_t consumeResults(TFunc func);
+
+    /**
+    * Approximate fraction of the reduction of the mesh that is done - the number of collapses relative to the
+    * number of vertices, 0 while the mesh is loaded. Returns 1 for finished and unknown meshes.
+    * Can be called while the workers are running.
+    */
+    float getProgress(size_t meshIdx) const;
+
+    bool isBusy() const { return m_pendingCount > 0; }
+
+private:
+    // Collapses until the mesh is maximally reduced or shouldStop() returns true.
+    // Returns true if the reduction is finished.
+    template<class TStopFunc>
+    bool reduce(Job& job, TStopFunc shouldStop);
+    // Writes the progressive mesh file and publishes the result
+    void finish(Job& job);
+
+#ifdef EMSCRIPTEN
+    // Reduces the jobs in start order until the time budget is used up
+    void processSliced();
+#else
+    // Waits for queued jobs and processes them until the reducer is destroyed
+    void workerLoop();
+#endif
+
+private:
+    std::vector<std::unique_ptr<Job>> m_jobs;
+#ifndef EMSCRIPTEN
+    // Guards the job list, m_nextJobIdx, m_idleWorkerCount and the workers
+    std::mutex m_jobMutex;
+    std::condition_variable m_jobAdded;
+    size_t m_nextJobIdx{ 0 };
+    size_t m_idleWorkerCount{ 0 };
+    std::vector<std::thread> m_workers;
+#endif
+    MpscQueue<MeshReductionResult> m_results;
+    std::atomic<bool> m_cancel{ false };
+    size_t m_pendingCount{ 0 };
+};
+
+template<class TFunc>
+size_t BackgroundMeshReducer::consumeResults(TFunc func)
+{
+#ifdef EMSCRIPTEN
+    processSliced();
+#endif
+
+    size_t count = m_results.consume(func);
+    m_pendingCount -= count;
+    return count;
+}
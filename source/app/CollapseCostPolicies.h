@@ -0,0 +1,287 @@
+#pragma once
+#include "DirectedEdgeMesh.h"
+#include <cmath>
+#include <limits>
+
+/**
+* Cost policies of BasicReducibleDirectedEdgeMesh. The policy is a template parameter, so the cost evaluation
+* is inlined into the reduction loop. A policy provides:
+* - void init(const TMesh& mesh): called once after the connectivity of the mesh is built
+* - uint32_t computeCost(const TMesh& mesh, EdgeID edgeIdx) const: cost to collapse the start vertex of the edge into its end vertex
+* - UndoData onCollapse(const TMesh& mesh, EdgeID edgeIdx): called before the given edge is collapsed, returns what is needed to undo it
+* - void onSplit(const TMesh& mesh, EdgeID edgeIdx, const UndoData& undoData): undoes the most recent collapse (called after the split)
+* - float toError(uint32_t cost) const: converts a cost back to the geometric error
+* computeCost must not modify any state - it is called concurrently.
+*/
+
+// Convert float to an integer type to avoid floating point imprecision errors which fail the equality test on specific architectures.
+// Errors above UINT32_MAX / scale saturate to UINT32_MAX: their collapse order is arbitrary and toError() returns the limit.
+inline uint32_t errorToCost(float error, float scale)
+{
+    float cost = error * scale;
+    if (!(cost < float(std::numeric_limits<uint32_t>::max())))
+        return std::numeric_limits<uint32_t>::max();
+
+    return cost > 0.0f ? uint32_t(cost) : 0;
+}
+
+/**
+* The cost of a halfedge collapse is computed with the formula from the paper
+* "A Simple, Fast, and Effective Polygon Reduction Algorithm" by Stan Melax
+*/
+class MelaxCostPolicy
+{
+public:
+    template<class TMesh>
+    void init(const TMesh& mesh) {}
+
+    template<class TMesh>
+    uint32_t computeCost(const TMesh& mesh, EdgeID edgeIdx) const;
+
+    // The policy has no state that changes with a collapse.
+    struct UndoData {};
+
+    template<class TMesh>
+    UndoData onCollapse(const TMesh& mesh, EdgeID edgeIdx) { return UndoData(); }
+
+    template<class TMesh>
+    void onSplit(const TMesh& mesh, EdgeID edgeIdx, const UndoData& undoData) {}
+
+    float toError(uint32_t cost) const { return cost / COST_SCALE; }
+
+private:
+    // Resolution of 1e-8. Errors saturate at UINT32_MAX / COST_SCALE (about 42.9), meshes mapped to the unit cube stay far below.
+    static constexpr float COST_SCALE = 10e7f;
+};
+
+/**
+* Symmetric 4x4 matrix stored as its upper triangle:
+* | a2 ab ac ad |
+* |    b2 bc bd |
+* |       c2 cd |
+* |          d2 |
+*/
+struct Quadric
+{
+    Quadric() {}
+
+    // The quadric of the plane n * x + d = 0 with the given weight.
+    Quadric(const glm::vec3& n, float d, float weight)
+        :a2(weight * n.x * n.x), ab(weight * n.x * n.y), ac(weight * n.x * n.z), ad(weight * n.x * d),
+         b2(weight * n.y * n.y), bc(weight * n.y * n.z), bd(weight * n.y * d),
+         c2(weight * n.z * n.z), cd(weight * n.z * d),
+         d2(weight * d * d) {}
+
+    Quadric& operator+=(const Quadric& q);
+    Quadric operator+(const Quadric& q) const { Quadric r = *this; r += q; return r; }
+
+    // Computes v^T * Q * v with v = (p, 1)
+    float evaluate(const glm::vec3& p) const;
+
+    float a2{ 0.0f }, ab{ 0.0f }, ac{ 0.0f }, ad{ 0.0f };
+    float b2{ 0.0f }, bc{ 0.0f }, bd{ 0.0f };
+    float c2{ 0.0f }, cd{ 0.0f };
+    float d2{ 0.0f };
+};
+
+/**
+* Quadric error metric from the paper "Surface Simplification Using Quadric Error Metrics" by Garland and Heckbert.
+* Every vertex stores the sum of the area weighted quadrics of its planes. Border edges add perpendicular constraint planes
+* to preserve the silhouette of open meshes. The vertex positions are fixed (halfedge collapse), so the cost of a collapse
+* is the error of the end vertex with respect to the combined quadric of both vertices.
+*/
+class QuadricCostPolicy
+{
+public:
+    // The previous quadric of the remaining vertex. Subtracting the quadric of the deleted vertex again wouldn't be exact.
+    struct UndoData
+    {
+        Quadric quadric;
+    };
+
+    template<class TMesh>
+    void init(const TMesh& mesh);
+
+    template<class TMesh>
+    uint32_t computeCost(const TMesh& mesh, EdgeID edgeIdx) const;
+
+    template<class TMesh>
+    UndoData onCollapse(const TMesh& mesh, EdgeID edgeIdx);
+
+    template<class TMesh>
+    void onSplit(const TMesh& mesh, EdgeID edgeIdx, const UndoData& undoData);
+
+    // The cost is proportional to the square root of the quadric error to get a distance like measure
+    // which fits into the integer range. The error is the quadric error again (an area weighted squared distance).
+    float toError(uint32_t cost) const { float d = cost / COST_SCALE; return d * d; }
+
+    const Quadric& getQuadric(VertexIndex vIdx) const { return m_quadrics[vIdx]; }
+
+private:
+    // The square root of the quadric error saturates at UINT32_MAX / COST_SCALE (about 42.9), i.e. quadric errors above
+    // about 1800 get the same cost. Flipping collapses are raised to FLIP_PENALTY (a root error of about 21.5),
+    // which only postpones them behind collapses with a smaller error.
+    static constexpr float COST_SCALE = 10e7f;
+    static constexpr float BORDER_WEIGHT = 100.0f;
+    // Collapses that flip a face are postponed by this cost.
+    static constexpr uint32_t FLIP_PENALTY = std::numeric_limits<uint32_t>::max() / 2;
+
+    std::vector<Quadric> m_quadrics;
+};
+
+template <class TMesh>
+uint32_t MelaxCostPolicy::computeCost(const TMesh& mesh, EdgeID edgeIdx) const
+{
+    auto& edges = mesh.getEdges();
+    auto positions = mesh.getGeometry().positions;
+
+    auto vi0 = edges[edgeIdx].vertexIdx;
+    auto vi1 = edges[TMesh::next(edgeIdx)].vertexIdx;
+
+    float edgeLength = glm::length(positions[vi0] - positions[vi1]);
+    float curvature = 0.0f;
+
+    // The faces adjacent to both vertices are the faces of the edge
+    FaceIndex adjFacesEdge[2];
+    uint32_t adjFacesEdgeCount = 0;
+    adjFacesEdge[adjFacesEdgeCount++] = edgeIdx / 3;
+
+    if (edges[edgeIdx].opposite >= 0)
+        adjFacesEdge[adjFacesEdgeCount++] = edges[edgeIdx].opposite / 3;
+
+    mesh.forEachAdjacentFace(vi0, [&](FaceIndex adjFaceStart)
+    {
+        float minCurvature = 1.0f;
+        auto& n0 = mesh.getFaceNormal(adjFaceStart);
+
+        for (uint32_t j = 0; j < adjFacesEdgeCount; ++j)
+        {
+            auto& n1 = mesh.getFaceNormal(adjFacesEdge[j]);
+            auto d = glm::dot(n0, n1);
+            minCurvature = std::min(minCurvature, (1.0f - d) / 2.0f);
+        }
+
+        curvature = std::max(curvature, minCurvature);
+    });
+
+    return errorToCost(edgeLength * curvature, COST_SCALE);
+}
+
+inline Quadric& Quadric::operator+=(const Quadric& q)
+{
+    a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+    b2 += q.b2; bc += q.bc; bd += q.bd;
+    c2 += q.c2; cd += q.cd;
+    d2 += q.d2;
+    return *this;
+}
+
+inline float Quadric::evaluate(const glm::vec3& p) const
+{
+    return a2 * p.x * p.x + 2.0f * ab * p.x * p.y + 2.0f * ac * p.x * p.z + 2.0f * ad * p.x
+                          + b2 * p.y * p.y + 2.0f * bc * p.y * p.z + 2.0f * bd * p.y
+                          + c2 * p.z * p.z + 2.0f * cd * p.z
+                          + d2;
+}
+
+template <class TMesh>
+void QuadricCostPolicy::init(const TMesh& mesh)
+{
+    auto& edges = mesh.getEdges();
+    auto positions = mesh.getGeometry().positions;
+
+    m_quadrics.clear();
+    m_quadrics.resize(mesh.getVertices().size());
+
+    for (size_t f = 0; f < edges.size() / 3; ++f)
+    {
+        EdgeID e = EdgeID(f * 3);
+        auto& p0 = positions[edges[e].vertexIdx];
+        auto& p1 = positions[edges[e + 1].vertexIdx];
+        auto& p2 = positions[edges[e + 2].vertexIdx];
+
+        glm::vec3 c = glm::cross(p1 - p0, p2 - p0);
+        float doubleArea = glm::length(c);
+        if (doubleArea <= 0.0f)
+            continue;
+
+        glm::vec3 n = c / doubleArea;
+        Quadric q(n, -glm::dot(n, p0), 0.5f * doubleArea);
+
+        for (EdgeID i = e; i < e + 3; ++i)
+        {
+            m_quadrics[edges[i].vertexIdx] += q;
+
+            if (edges[i].opposite >= 0)
+                continue;
+
+            // Constraint plane through the border edge which is perpendicular to the face
+            auto& b0 = positions[edges[i].vertexIdx];
+            auto& b1 = positions[edges[TMesh::next(i)].vertexIdx];
+            glm::vec3 borderNormal = glm::cross(b1 - b0, n);
+            float length2 = glm::dot(borderNormal, borderNormal);
+            if (length2 <= 0.0f)
+                continue;
+
+            borderNormal /= std::sqrt(length2);
+            Quadric borderQuadric(borderNormal, -glm::dot(borderNormal, b0), BORDER_WEIGHT * length2);
+            m_quadrics[edges[i].vertexIdx] += borderQuadric;
+            m_quadrics[edges[TMesh::next(i)].vertexIdx] += borderQuadric;
+        }
+    }
+}
+
+template <class TMesh>
+uint32_t QuadricCostPolicy::computeCost(const TMesh& mesh, EdgeID edgeIdx) const
+{
+    auto& edges = mesh.getEdges();
+    auto positions = mesh.getGeometry().positions;
+
+    auto vi0 = edges[edgeIdx].vertexIdx;
+    auto vi1 = edges[TMesh::next(edgeIdx)].vertexIdx;
+    auto& target = positions[vi1];
+
+    float error = std::max((m_quadrics[vi0] + m_quadrics[vi1]).evaluate(target), 0.0f);
+    uint32_t cost = errorToCost(std::sqrt(error), COST_SCALE);
+
+    // Moving vi0 to vi1 must not flip any of the remaining faces
+    bool flipped = false;
+    mesh.forEachEmanatingEdge(vi0, [&](EdgeID e)
+    {
+        auto& pNext = positions[edges[TMesh::next(e)].vertexIdx];
+        auto& pPrev = positions[edges[TMesh::prev(e)].vertexIdx];
+
+        // Faces of the collapsed edge are removed
+        if (edges[TMesh::next(e)].vertexIdx == vi1 || edges[TMesh::prev(e)].vertexIdx == vi1)
+            return;
+
+        glm::vec3 n = glm::cross(pNext - target, pPrev - target);
+        if (glm::dot(n, mesh.getFaceNormal(e / 3)) <= 0.0f)
+            flipped = true;
+    });
+
+    if (flipped && cost < FLIP_PENALTY)
+        return FLIP_PENALTY;
+
+    return cost;
+}
+
+template <class TMesh>
+QuadricCostPolicy::UndoData QuadricCostPolicy::onCollapse(const TMesh& mesh, EdgeID edgeIdx)
+{
+    auto& edges = mesh.getEdges();
+    auto& quadric = m_quadrics[edges[TMesh::next(edgeIdx)].vertexIdx];
+
+    UndoData undoData;
+    undoData.quadric = quadric;
+    quadric += m_quadrics[edges[edgeIdx].vertexIdx];
+
+    return undoData;
+}
+
+template <class TMesh>
+void QuadricCostPolicy::onSplit(const TMesh& mesh, EdgeID edgeIdx, const UndoData& undoData)
+{
+    auto& edges = mesh.getEdges();
+    m_quadrics[edges[TMesh::next(edgeIdx)].vertexIdx] = undoData.quadric;
+}
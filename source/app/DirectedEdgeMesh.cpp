@@ -1,168 +1,273 @@
 #include "DirectedEdgeMesh.h"
-#include <unordered_map>
+#include <engine/util/ThreadPool.h>
 
 DirectedEdgeMesh::DirectedEdgeMesh(const Mesh::SubMesh& subMesh)
+    :DirectedEdgeMesh(GeometryView::copyFrom(subMesh)) {}
+
+DirectedEdgeMesh::DirectedEdgeMesh(const GeometryView& geometry)
+    :m_geometry(geometry)
 {
-    assert(subMesh.vertices.size() > 0);
-    assert(subMesh.indices.size() > 0);
+    initEdges();
+    initOpposites();
+
+    for (size_t i = 0; i < m_edges.size(); ++i)
+    {
+        if (m_edges[i].opposite >= 0)
+            assert(m_edges[m_edges[i].opposite].opposite == EdgeID(i));
+    }
+
+    initBorderVertices();
+}
+
+DirectedEdgeMesh::DirectedEdgeMesh(const GeometryView& geometry, const EdgeID* opposites, size_t nonManifoldEdgeCount)
+    :DirectedEdgeMesh(geometry, TopologyView(opposites, nonManifoldEdgeCount)) {}
+
+DirectedEdgeMesh::DirectedEdgeMesh(const GeometryView& geometry, const TopologyView& topology)
+    :m_geometry(geometry), m_nonManifoldEdgeCount(topology.nonManifoldEdgeCount)
+{
+    initEdges();
+
+    if (!topology.opposites)
+    {
+        initOpposites();
+        initBorderVertices();
+        return;
+    }
+
+    for (size_t i = 0; i < m_edges.size(); ++i)
+    {
+        m_edges[i].opposite = topology.opposites[i];
+        assert(topology.opposites[i] < EdgeID(m_edges.size()));
+    }
+
+    if (!topology.vertices)
+    {
+        initBorderVertices();
+        return;
+    }
+
+    m_vertices.assign(topology.vertices, topology.vertices + m_geometry.vertexCount);
+    m_borderEdgeLists.assign(topology.borderEdgeLists, topology.borderEdgeLists + topology.borderEdgeListCount);
+    m_borderEmanatingEdges.assign(topology.borderEmanatingEdges, topology.borderEmanatingEdges + topology.borderEmanatingEdgeCount);
+}
 
-    m_subMesh = subMesh;
-    m_vertices.resize(subMesh.vertices.size());
-    m_edges.resize(subMesh.indices.size());
+void DirectedEdgeMesh::initEdges()
+{
+    assert(m_geometry.vertexCount > 0);
+    assert(m_geometry.indexCount > 0);
 
-    std::unordered_map<uint64_t, EdgeID> halfedgeMap;
-    size_t halfedgeCount = m_subMesh.indices.size();
+    m_vertices.resize(m_geometry.vertexCount);
+    m_edges.resize(m_geometry.indexCount);
 
-    for (size_t i = 0; i < halfedgeCount; ++i)
+    for (size_t i = 0; i < m_edges.size(); ++i)
     {
-        VertexID vID = m_subMesh.indices[i];
-        auto& halfedge = m_edges[i];
-        halfedge.vertexIdx = vID;
+        VertexID vID = m_geometry.indices[i];
+        m_edges[i].vertexIdx = vID;
         m_vertices[vID].id = vID;
         m_vertices[vID].edgeID = EdgeID(i);
+    }
+}
 
-        auto nextIdx = next(i);
-        VertexID nextVID = m_subMesh.indices[nextIdx];
+void DirectedEdgeMesh::initOpposites()
+{
+    struct EdgeKey
+    {
+        // (min vertex, max vertex) of the halfedge - both halfedges of an edge have the same key
+        uint64_t vertexPair;
+        EdgeID edgeIdx;
+    };
 
-        auto edgeKey = uint64_t(vID) * halfedgeCount + uint64_t(nextVID);
+    auto& threadPool = ThreadPool::getDefault();
+    std::vector<EdgeKey> keys(m_edges.size());
 
-        // 2 Halfedges from v0 to v1 should not exist (non-manifold)
-        assert(halfedgeMap.count(edgeKey) == 0);
+    threadPool.parallelFor(keys.size(), [this, &keys](size_t i)
+    {
+        uint64_t v0 = m_edges[i].vertexIdx;
+        uint64_t v1 = m_edges[next(i)].vertexIdx;
+        keys[i].vertexPair = (std::min(v0, v1) << 32) | std::max(v0, v1);
+        keys[i].edgeIdx = EdgeID(i);
+    });
+
+    // The EdgeID breaks ties to get the same order independent of the number of threads.
+    threadPool.sort(keys.begin(), keys.end(), [](const EdgeKey& lhs, const EdgeKey& rhs)
+    {
+        return lhs.vertexPair < rhs.vertexPair || (lhs.vertexPair == rhs.vertexPair && lhs.edgeIdx < rhs.edgeIdx);
+    });
 
-        halfedgeMap[edgeKey] = EdgeID(i);
+    // Halfedges of the same edge are neighbors now. Every chunk matches the runs of equal keys that start in it.
+    size_t count = keys.size();
+    size_t chunkCount = std::max(threadPool.computeChunkCount(count), size_t(1));
+    std::vector<size_t> nonManifoldEdgeCounts(chunkCount, 0);
 
-        auto oppositeKey = uint64_t(nextVID) * halfedgeCount + uint64_t(vID);
-        auto it = halfedgeMap.find(oppositeKey);
-        if (it != halfedgeMap.end())
+    threadPool.run(chunkCount, [this, &keys, count, chunkCount, &nonManifoldEdgeCounts](size_t chunkIdx)
+    {
+        size_t i = chunkIdx * count / chunkCount;
+        size_t end = (chunkIdx + 1) * count / chunkCount;
+
+        while (i > 0 && i < end && keys[i].vertexPair == keys[i - 1].vertexPair)
+            ++i;
+
+        while (i < end)
         {
-            halfedge.opposite = it->second;
-            m_edges[halfedge.opposite].opposite = i;
+            size_t runEnd = i + 1;
+            while (runEnd < count && keys[runEnd].vertexPair == keys[i].vertexPair)
+                ++runEnd;
+
+            EdgeID e0 = keys[i].edgeIdx;
+
+            if (runEnd - i == 2 && m_edges[e0].vertexIdx != m_edges[keys[i + 1].edgeIdx].vertexIdx)
+            {
+                EdgeID e1 = keys[i + 1].edgeIdx;
+                m_edges[e0].opposite = e1;
+                m_edges[e1].opposite = e0;
+            }
+            else if (runEnd - i > 1)
+            {
+                // More than two faces or inconsistent orientation -> all halfedges stay border edges
+                ++nonManifoldEdgeCounts[chunkIdx];
+            }
+
+            i = runEnd;
         }
-    }
+    });
 
+    m_nonManifoldEdgeCount = 0;
+    for (auto nonManifoldEdgeCount : nonManifoldEdgeCounts)
+        m_nonManifoldEdgeCount += nonManifoldEdgeCount;
+}
+
+void DirectedEdgeMesh::initBorderVertices()
+{
+    // Border vertices are the start of a halfedge without opposite.
+    // IDs are assigned in the order of their first border halfedge.
     for (size_t i = 0; i < m_edges.size(); ++i)
     {
-        if (m_edges[i].opposite >= 0)
-            assert(m_edges[m_edges[i].opposite].opposite == EdgeID(i));
+        auto& v = m_vertices[m_edges[i].vertexIdx];
+        if (m_edges[i].opposite < 0 && v.id >= 0)
+        {
+            m_borderEdgeLists.push_back(BorderEdgeList());
+            v.id = -VertexID(m_borderEdgeLists.size());
+        }
     }
 
-    // Set up border vertices
+    // Counting sort of the halfedges by their border start vertex
     for (size_t i = 0; i < m_edges.size(); ++i)
     {
-        if (m_edges[i].opposite < 0)
-        {
-            if (m_vertices[m_edges[i].vertexIdx].id < 0)
-                continue;
-
-            auto e = findEmanatingEdges(m_edges[i].vertexIdx);
-            m_emanatingEdges.push_back(e);
-            m_vertices[m_edges[i].vertexIdx].id = -VertexID(m_emanatingEdges.size());
-        }
+        auto vID = m_vertices[m_edges[i].vertexIdx].id;
+        if (vID < 0)
+            ++m_borderEdgeLists[-vID - 1].count;
     }
-}
 
-uint32_t DirectedEdgeMesh::valenceOf(VertexIndex vertexIdx)
-{
-    return getNeighbors(vertexIdx).size();
-}
+    uint32_t offset = 0;
+    for (auto& list : m_borderEdgeLists)
+    {
+        list.offset = offset;
+        list.capacity = list.count * BORDER_EDGE_LIST_GROWTH;
+        list.count = 0;
+        offset += list.capacity;
+    }
 
-std::vector<VertexIndex> DirectedEdgeMesh::getNeighbors(VertexIndex vertexIdx)
-{
-    auto vID = m_vertices[vertexIdx].id;
+    m_borderEmanatingEdges.resize(offset);
 
-    std::vector<VertexIndex> adjacent;
-    if (vID < 0)
+    for (size_t i = 0; i < m_edges.size(); ++i)
     {
-        auto& emanatingEdges = m_emanatingEdges[-vID - 1];
-        for (auto i : emanatingEdges)
+        auto vID = m_vertices[m_edges[i].vertexIdx].id;
+        if (vID < 0)
         {
-            addIfNew(adjacent, m_edges[next(i)].vertexIdx);
-            addIfNew(adjacent, m_edges[prev(i)].vertexIdx);
+            auto& list = m_borderEdgeLists[-vID - 1];
+            m_borderEmanatingEdges[list.offset + list.count++] = EdgeID(i);
         }
-
-        return adjacent;
     }
+}
 
-    EdgeID startIdx = m_vertices[vertexIdx].edgeID;
-    EdgeID curIndex = startIdx;
+void DirectedEdgeMesh::addBorderVertex(VertexIndex vIdx, const std::vector<EdgeID>& emanatingEdges)
+{
+    assert(!isBorderVertex(vIdx));
 
-    do
-    {
-        assert(m_edges[curIndex].opposite >= 0);
-        curIndex = next(m_edges[curIndex].opposite);
-        adjacent.push_back(m_edges[m_edges[curIndex].opposite].vertexIdx);
-    } while (curIndex != startIdx);
+    BorderEdgeList list;
+    list.offset = uint32_t(m_borderEmanatingEdges.size());
+    list.count = uint32_t(emanatingEdges.size());
+    list.capacity = list.count * BORDER_EDGE_LIST_GROWTH;
 
-    return adjacent;
+    m_borderEmanatingEdges.insert(m_borderEmanatingEdges.end(), emanatingEdges.begin(), emanatingEdges.end());
+    m_borderEmanatingEdges.resize(list.offset + list.capacity);
+    m_borderEdgeLists.push_back(list);
+    m_vertices[vIdx].id = -VertexID(m_borderEdgeLists.size());
 }
 
-std::vector<EdgeID> DirectedEdgeMesh::findEmanatingEdges(VertexIndex vIdx)
+void DirectedEdgeMesh::addBorderEmanatingEdge(VertexIndex vIdx, EdgeID edgeIdx)
 {
-    std::vector<EdgeID> emanating;
+    assert(isBorderVertex(vIdx));
+    auto& list = m_borderEdgeLists[-m_vertices[vIdx].id - 1];
 
-    size_t i = 0;
-    while (i < m_edges.size())
+    if (list.count == list.capacity)
     {
-        if (vIdx == VertexIndex(m_edges[i].vertexIdx))
-        {
-            emanating.push_back(i);
-            i = ((i + 3) / 3) * 3;
-        }
-        else
-            ++i;
+        // Move the list to the end - the old range is not reused
+        uint32_t newOffset = uint32_t(m_borderEmanatingEdges.size());
+        list.capacity = std::max(list.capacity * BORDER_EDGE_LIST_GROWTH, list.count + 1);
+        m_borderEmanatingEdges.resize(newOffset + list.capacity);
+        std::copy(m_borderEmanatingEdges.begin() + list.offset, m_borderEmanatingEdges.begin() + list.offset + list.count,
+                  m_borderEmanatingEdges.begin() + newOffset);
+        list.offset = newOffset;
     }
 
-    return emanating;
+    m_borderEmanatingEdges[list.offset + list.count++] = edgeIdx;
 }
 
-std::vector<EdgeID> DirectedEdgeMesh::getEmanatingEdges(VertexIndex vIdx)
+uint32_t DirectedEdgeMesh::valenceOf(VertexIndex vertexIdx) const
 {
-    if (m_vertices[vIdx].id < 0)
-        return m_emanatingEdges[-m_vertices[vIdx].id - 1];
+    uint32_t valence = 0;
+    forEachNeighbor(vertexIdx, [&valence](VertexIndex) { ++valence; });
+    return valence;
+}
 
-    std::vector<EdgeID> emanating;
-    EdgeID startIdx = m_vertices[vIdx].edgeID;
-    EdgeID curIndex = startIdx;
+std::vector<VertexIndex> DirectedEdgeMesh::getNeighbors(VertexIndex vertexIdx) const
+{
+    std::vector<VertexIndex> adjacent;
+    getNeighbors(vertexIdx, adjacent);
+    return adjacent;
+}
 
-    do
-    {
-        assert(m_edges[curIndex].opposite >= 0);
-        curIndex = next(m_edges[curIndex].opposite);
-        emanating.push_back(curIndex);
-    } while (curIndex != startIdx);
+void DirectedEdgeMesh::getNeighbors(VertexIndex vertexIdx, std::vector<VertexIndex>& outNeighbors) const
+{
+    outNeighbors.clear();
+    forEachNeighbor(vertexIdx, [&outNeighbors](VertexIndex n) { outNeighbors.push_back(n); });
+}
 
+std::vector<EdgeID> DirectedEdgeMesh::getEmanatingEdges(VertexIndex vIdx) const
+{
+    std::vector<EdgeID> emanating;
+    getEmanatingEdges(vIdx, emanating);
     return emanating;
 }
 
-std::vector<FaceIndex> DirectedEdgeMesh::getAdjacentFaces(VertexIndex vIdx)
+void DirectedEdgeMesh::getEmanatingEdges(VertexIndex vIdx, std::vector<EdgeID>& outEdges) const
 {
-    auto emanatingEdges = getEmanatingEdges(vIdx);
+    outEdges.clear();
+    forEachEmanatingEdge(vIdx, [&outEdges](EdgeID e) { outEdges.push_back(e); });
+}
 
+std::vector<FaceIndex> DirectedEdgeMesh::getAdjacentFaces(VertexIndex vIdx) const
+{
     std::vector<FaceIndex> faces;
-
-    for (auto i : emanatingEdges)
-        faces.push_back(i / 3);
-
+    forEachAdjacentFace(vIdx, [&faces](FaceIndex f) { faces.push_back(f); });
     return faces;
 }
 
-glm::vec3 DirectedEdgeMesh::computeFaceNormal(FaceIndex faceIdx)
+glm::vec3 DirectedEdgeMesh::computeFaceNormal(FaceIndex faceIdx) const
 {
     auto edgeStart = faceIdx * 3;
-    auto v0 = m_subMesh.vertices[m_edges[edgeStart].vertexIdx];
-    auto v1 = m_subMesh.vertices[m_edges[edgeStart + 1].vertexIdx];
-    auto v2 = m_subMesh.vertices[m_edges[edgeStart + 2].vertexIdx];
+    auto v0 = m_geometry.positions[m_edges[edgeStart].vertexIdx];
+    auto v1 = m_geometry.positions[m_edges[edgeStart + 1].vertexIdx];
+    auto v2 = m_geometry.positions[m_edges[edgeStart + 2].vertexIdx];
 
     return glm::normalize(glm::cross(v1 - v0, v2 - v0));
 }
 
-glm::vec3 DirectedEdgeMesh::computeVertexNormal(VertexIndex vIdx)
+glm::vec3 DirectedEdgeMesh::computeVertexNormal(VertexIndex vIdx) const
 {
-    auto adjFaces = getAdjacentFaces(vIdx);
     glm::vec3 normal(0.f);
-
-    for (auto faceIdx : adjFaces)
-        normal += computeFaceNormal(faceIdx);
+    forEachAdjacentFace(vIdx, [this, &normal](FaceIndex faceIdx) { normal += computeFaceNormal(faceIdx); });
 
     return glm::normalize(normal);
 }
@@ -170,12 +275,12 @@ glm::vec3 DirectedEdgeMesh::computeVertexNormal(VertexIndex vIdx)
 std::vector<VertexIndex> DirectedEdgeMesh::findNeighbors(VertexIndex vID)
 {
     std::vector<VertexIndex> neighbors;
-    auto& indices = m_subMesh.indices;
+    auto indices = m_geometry.indices;
 
     size_t i = 0;
-    while (i < m_subMesh.indices.size())
+    while (i < m_geometry.indexCount)
     {
-        if (vID == VertexIndex(m_subMesh.indices[i]))
+        if (vID == VertexIndex(indices[i]))
         {
             addIfNew(neighbors, indices[next(i)]);
             addIfNew(neighbors, indices[prev(i)]);
@@ -188,7 +293,7 @@ std::vector<VertexIndex> DirectedEdgeMesh::findNeighbors(VertexIndex vID)
     return neighbors;
 }
 
-bool DirectedEdgeMesh::doesVertexBelongToFace(FaceIndex faceIdx, VertexIndex vertexIdx)
+bool DirectedEdgeMesh::doesVertexBelongToFace(FaceIndex faceIdx, VertexIndex vertexIdx) const
 {
     EdgeID i = faceIdx * 3;
     return (m_edges[i].vertexIdx == vertexIdx ||
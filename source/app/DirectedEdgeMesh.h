@@ -1,6 +1,8 @@
 #pragma once
 #include <vector>
+#include <algorithm>
 #include <engine/rendering/geometry/Mesh.h>
+#include "GeometryView.h"
 #include <set>
 
 using VertexID = int32_t;
@@ -26,22 +28,78 @@ struct HalfedgeVertex
 };
 
 /**
-* Note: getNeighbors, getEmanatingEdges, getAdjacentFaces and set operations add a lot of allocation and deallocation overhead.
-* Preallocated pools would increase the speed of the algorithm considerably.
+* Reusable buffers for callers that need a materialized one-ring.
+* The buffers keep their capacity between uses, so filling them doesn't allocate once they are warmed up.
+*/
+struct RingScratchArena
+{
+    std::vector<VertexIndex> vertices;
+    std::vector<EdgeID> edges;
+    std::vector<EdgeID> edgesOfNext;
+    std::vector<EdgeID> affectedEdges;
+};
+
+/**
+* Emanating edges of a border vertex are stored in [offset, offset + count) of one flat array.
+* A list grows in place up to its capacity, otherwise it is moved to the end of the array.
+*/
+struct BorderEdgeList
+{
+    uint32_t offset{ 0 };
+    uint32_t count{ 0 };
+    uint32_t capacity{ 0 };
+};
+
+/**
+* Precomputed connectivity of a mesh that hasn't been changed yet, e.g. stored in a MeshFile.
+* Null arrays are rebuilt from the geometry.
+*/
+struct TopologyView
+{
+    TopologyView() {}
+    TopologyView(const EdgeID* opposites, size_t nonManifoldEdgeCount)
+        :opposites(opposites), nonManifoldEdgeCount(nonManifoldEdgeCount) {}
+
+    // Opposite halfedge of every halfedge (BOUNDARY_EDGE for border edges)
+    const EdgeID* opposites{ nullptr };
+    size_t nonManifoldEdgeCount{ 0 };
+
+    // Vertices and border emanating edge lists as built by DirectedEdgeMesh - only used together with the opposites
+    const HalfedgeVertex* vertices{ nullptr };
+    const BorderEdgeList* borderEdgeLists{ nullptr };
+    size_t borderEdgeListCount{ 0 };
+    const EdgeID* borderEmanatingEdges{ nullptr };
+    size_t borderEmanatingEdgeCount{ 0 };
+};
+
+/**
+* Note: getNeighbors, getEmanatingEdges and getAdjacentFaces return a new vector and thus add allocation overhead.
+* Use the forEach* circulators which walk the one-ring in place or the overloads that fill a scratch buffer.
 */
 class DirectedEdgeMesh
 {
 public:
     /**
     * Expecting a 2-manifold mesh (optionally with borders) as input. 
-    * Note: Behaviour for non-manifold geometry is undefined.
+    * Non-manifold edges (shared by more than two faces or by two faces with inconsistent orientation)
+    * are split into border edges and counted (see getNonManifoldEdgeCount). ReducibleDirectedEdgeMesh keeps their vertices.
+    * Note: Behaviour for other non-manifold geometry is undefined.
     */
+    explicit DirectedEdgeMesh(const GeometryView& geometry);
+    // Copies the positions and indices of the sub mesh once - copies of the DirectedEdgeMesh share them.
     explicit DirectedEdgeMesh(const Mesh::SubMesh& subMesh);
+    // Uses the given opposite halfedges of a previously built mesh (e.g. a ProgressiveMeshFile) instead of matching them.
+    DirectedEdgeMesh(const GeometryView& geometry, const EdgeID* opposites, size_t nonManifoldEdgeCount);
+    // Copies the given connectivity instead of building it (see TopologyView).
+    DirectedEdgeMesh(const GeometryView& geometry, const TopologyView& topology);
     DirectedEdgeMesh() {}
     virtual ~DirectedEdgeMesh() {}
 
     const std::vector<HalfedgeVertex>& getVertices() const { return m_vertices; }
     const std::vector<Halfedge>& getEdges() const { return m_edges; }
+    size_t getNonManifoldEdgeCount() const { return m_nonManifoldEdgeCount; }
+    const std::vector<BorderEdgeList>& getBorderEdgeLists() const { return m_borderEdgeLists; }
+    const std::vector<EdgeID>& getBorderEmanatingEdges() const { return m_borderEmanatingEdges; }
 
     template<class T>
     static T next(T idx);
@@ -49,34 +107,76 @@ public:
     template<class T>
     static T prev(T idx);
 
-    uint32_t valenceOf(VertexIndex vertexIdx);
+    uint32_t valenceOf(VertexIndex vertexIdx) const;
+    bool isBorderVertex(VertexIndex vertexIdx) const { return m_vertices[vertexIdx].id < 0; }
+
+    /**
+    * Circulators over the one-ring of a vertex. The ring is walked in place without allocations.
+    * Interior vertices are circulated via the opposite halfedges, border vertices via their emanating edge lists.
+    */
+    template<class TFunc>
+    void forEachEmanatingEdge(VertexIndex vIdx, TFunc func) const;
+
+    template<class TFunc>
+    void forEachNeighbor(VertexIndex vIdx, TFunc func) const;
+
+    template<class TFunc>
+    void forEachAdjacentFace(VertexIndex vIdx, TFunc func) const;
 
-    std::vector<VertexIndex> getNeighbors(VertexIndex vertexIdx);
+    std::vector<VertexIndex> getNeighbors(VertexIndex vertexIdx) const;
+    // Clears the given vector and fills it with the neighbors.
+    void getNeighbors(VertexIndex vertexIdx, std::vector<VertexIndex>& outNeighbors) const;
 
     std::vector<VertexIndex> findNeighbors(VertexIndex vID);
 
     template<class T>
     void addIfNew(std::vector<T>& v, const T& elem);
 
-    bool doesVertexBelongToFace(FaceIndex faceIdx, VertexIndex vertexIdx);
+    bool doesVertexBelongToFace(FaceIndex faceIdx, VertexIndex vertexIdx) const;
 
-    std::vector<EdgeID> getEmanatingEdges(VertexIndex vIdx);
-    std::vector<FaceIndex> getAdjacentFaces(VertexIndex vIdx);
+    std::vector<EdgeID> getEmanatingEdges(VertexIndex vIdx) const;
+    // Clears the given vector and fills it with the emanating edges.
+    void getEmanatingEdges(VertexIndex vIdx, std::vector<EdgeID>& outEdges) const;
+    std::vector<FaceIndex> getAdjacentFaces(VertexIndex vIdx) const;
 
-    glm::vec3 computeFaceNormal(FaceIndex faceIdx);
-    glm::vec3 computeVertexNormal(VertexIndex vIdx);
+    glm::vec3 computeFaceNormal(FaceIndex faceIdx) const;
+    glm::vec3 computeVertexNormal(VertexIndex vIdx) const;
 
-    const Mesh::SubMesh& getSubMesh() const { return m_subMesh; }
+    const GeometryView& getGeometry() const { return m_geometry; }
+    const glm::vec3& getPosition(VertexIndex vIdx) const { return m_geometry.positions[vIdx]; }
 
 protected:
-    std::vector<EdgeID> findEmanatingEdges(VertexIndex vIdx);
+    // Sets the start vertices of the halfedges and the emanating edges of the vertices.
+    void initEdges();
+    // Matches the halfedges of every edge by sorting them by their vertex pair in O(E log E).
+    void initOpposites();
+    // Builds the emanating edge lists of all border vertices with a counting sort in O(E).
+    void initBorderVertices();
+
+    const BorderEdgeList& getBorderEdgeList(VertexIndex vIdx) const { return m_borderEdgeLists[-m_vertices[vIdx].id - 1]; }
+    // Turns the vertex into a border vertex with the given emanating edges.
+    void addBorderVertex(VertexIndex vIdx, const std::vector<EdgeID>& emanatingEdges);
+    void addBorderEmanatingEdge(VertexIndex vIdx, EdgeID edgeIdx);
+    // Removes the emanating edges of the border vertex that fulfill the predicate (keeps the order of the others).
+    // Returns the number of removed edges.
+    template<class TPredicate>
+    uint32_t removeBorderEmanatingEdges(VertexIndex vIdx, TPredicate predicate);
 
 protected:
-    Mesh::SubMesh m_subMesh;
+    // Lists are allocated with this factor times the initial number of edges to leave room for collapses.
+    static const uint32_t BORDER_EDGE_LIST_GROWTH = 2;
+
+    // Shared and immutable - only the topology below is copied with the mesh.
+    GeometryView m_geometry;
 
     std::vector<HalfedgeVertex> m_vertices;
     std::vector<Halfedge> m_edges;
-    std::vector<std::vector<EdgeID>> m_emanatingEdges;
+    // The index into the list vector corresponds to -HalfedgeVertex::id - 1 of a border vertex.
+    std::vector<BorderEdgeList> m_borderEdgeLists;
+    std::vector<EdgeID> m_borderEmanatingEdges;
+    size_t m_nonManifoldEdgeCount{ 0 };
+
+    RingScratchArena m_scratch;
 };
 
 template <class T>
@@ -97,3 +197,91 @@ void DirectedEdgeMesh::addIfNew(std::vector<T>& v, const T& elem)
     if (std::find(v.begin(), v.end(), elem) == v.end())
         v.push_back(elem);
 }
+
+template <class TFunc>
+void DirectedEdgeMesh::forEachEmanatingEdge(VertexIndex vIdx, TFunc func) const
+{
+    auto vID = m_vertices[vIdx].id;
+    if (vID < 0)
+    {
+        auto& list = m_borderEdgeLists[-vID - 1];
+        const EdgeID* edges = m_borderEmanatingEdges.data() + list.offset;
+
+        for (uint32_t i = 0; i < list.count; ++i)
+            func(edges[i]);
+
+        return;
+    }
+
+    EdgeID startIdx = m_vertices[vIdx].edgeID;
+    EdgeID curIndex = startIdx;
+
+    do
+    {
+        assert(m_edges[curIndex].opposite >= 0);
+        curIndex = next(m_edges[curIndex].opposite);
+        func(curIndex);
+    } while (curIndex != startIdx);
+}
+
+template <class TFunc>
+void DirectedEdgeMesh::forEachNeighbor(VertexIndex vIdx, TFunc func) const
+{
+    auto vID = m_vertices[vIdx].id;
+    if (vID < 0)
+    {
+        // The neighbors are the ends of the emanating edges and the starts of the incoming border edges.
+        // Non-manifold edges are split into several border halfedges between the same vertices, so a neighbor
+        // can be reached more than once - only its first occurrence is reported. Border lists are short,
+        // so the earlier edges are just scanned again.
+        auto& list = m_borderEdgeLists[-vID - 1];
+        const EdgeID* edges = m_borderEmanatingEdges.data() + list.offset;
+
+        auto endOf = [this](EdgeID e) { return m_edges[next(e)].vertexIdx; };
+        auto borderStartOf = [this](EdgeID e) { return m_edges[prev(e)].opposite < 0 ? m_edges[prev(e)].vertexIdx : INVALID_VERTEX_INDEX; };
+        auto reportedBefore = [&](uint32_t count, VertexIndex n)
+        {
+            for (uint32_t j = 0; j < count; ++j)
+                if (endOf(edges[j]) == n || borderStartOf(edges[j]) == n)
+                    return true;
+
+            return false;
+        };
+
+        for (uint32_t i = 0; i < list.count; ++i)
+        {
+            EdgeID e = edges[i];
+            VertexIndex end = endOf(e);
+            if (!reportedBefore(i, end))
+                func(end);
+
+            VertexIndex start = borderStartOf(e);
+            if (start != INVALID_VERTEX_INDEX && start != end && !reportedBefore(i, start))
+                func(start);
+        }
+
+        return;
+    }
+
+    forEachEmanatingEdge(vIdx, [this, &func](EdgeID e) { func(m_edges[m_edges[e].opposite].vertexIdx); });
+}
+
+template <class TFunc>
+void DirectedEdgeMesh::forEachAdjacentFace(VertexIndex vIdx, TFunc func) const
+{
+    forEachEmanatingEdge(vIdx, [&func](EdgeID e) { func(FaceIndex(e / 3)); });
+}
+
+template <class TPredicate>
+uint32_t DirectedEdgeMesh::removeBorderEmanatingEdges(VertexIndex vIdx, TPredicate predicate)
+{
+    assert(isBorderVertex(vIdx));
+    auto& list = m_borderEdgeLists[-m_vertices[vIdx].id - 1];
+    EdgeID* edges = m_borderEmanatingEdges.data() + list.offset;
+
+    uint32_t newCount = uint32_t(std::remove_if(edges, edges + list.count, predicate) - edges);
+    uint32_t removedCount = list.count - newCount;
+    list.count = newCount;
+
+    return removedCount;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <engine/rendering/geometry/Mesh.h>
+
+/**
+* Non-owning view of the immutable positions and indices of a triangle mesh.
+* The data is kept alive by the reference counted owner (e.g. a shared SubMesh or a memory mapped file),
+* so copies of the view - and of meshes that hold one - don't copy the geometry.
+*/
+struct GeometryView
+{
+    GeometryView() {}
+    GeometryView(const glm::vec3* positions, size_t vertexCount, const IndexType* indices, size_t indexCount, std::shared_ptr<const void> owner)
+        :positions(positions), indices(indices), vertexCount(vertexCount), indexCount(indexCount), owner(std::move(owner)) {}
+
+    /**
+    * Copies only the positions and indices of the sub mesh into shared storage.
+    */
+    static GeometryView copyFrom(const Mesh::SubMesh& subMesh);
+
+    /**
+    * Shares the given sub mesh without copying it.
+    */
+    static GeometryView share(std::shared_ptr<const Mesh::SubMesh> subMesh);
+
+    size_t getFaceCount() const { return indexCount / 3; }
+
+    const glm::vec3* positions{ nullptr };
+    const IndexType* indices{ nullptr };
+    size_t vertexCount{ 0 };
+    size_t indexCount{ 0 };
+    std::shared_ptr<const void> owner;
+};
+
+inline GeometryView GeometryView::copyFrom(const Mesh::SubMesh& subMesh)
+{
+    struct Storage
+    {
+        Vertices positions;
+        Indices indices;
+    };
+
+    auto storage = std::make_shared<Storage>();
+    storage->positions = subMesh.vertices;
+    storage->indices = subMesh.indices;
+
+    return GeometryView(storage->positions.data(), storage->positions.size(), storage->indices.data(), storage->indices.size(), storage);
+}
+
+inline GeometryView GeometryView::share(std::shared_ptr<const Mesh::SubMesh> subMesh)
+{
+    return GeometryView(subMesh->vertices.data(), subMesh->vertices.size(), subMesh->indices.data(), subMesh->indices.size(), subMesh);
+}
@@ -0,0 +1,125 @@
+#include "MeshContainer.h"
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <engine/util/Logger.h>
+
+namespace
+{
+    uint64_t alignSection(uint64_t offset, uint64_t alignment)
+    {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+}
+
+bool MeshContainer::write(const std::string& path, const char (&magic)[4], uint32_t version, uint64_t sourceStamp,
+                          const void* typeHeader, size_t typeHeaderSize, const Section* sections, size_t sectionCount)
+{
+    ContainerHeader header;
+    std::memcpy(header.magic, magic, sizeof(header.magic));
+    header.version = version;
+    header.byteOrderMark = BYTE_ORDER_MARK;
+    header.typeHeaderSize = uint32_t(typeHeaderSize);
+    header.sourceStamp = sourceStamp;
+
+    // The file is written next to the target and renamed into place, so readers (and mappings) of the
+    // previous file never see a partially written one
+    std::string tempPath = path + ".tmp";
+    std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+    if (!stream.is_open())
+    {
+        Logger::stream() << "Could not open file: " << tempPath << std::endl;
+        return false;
+    }
+
+    const char padding[SECTION_ALIGNMENT] = {};
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(ContainerHeader));
+    stream.write(static_cast<const char*>(typeHeader), std::streamsize(typeHeaderSize));
+    uint64_t offset = sizeof(ContainerHeader) + typeHeaderSize;
+
+    for (size_t i = 0; i < sectionCount; ++i)
+    {
+        uint64_t sectionStart = alignSection(offset, SECTION_ALIGNMENT);
+        stream.write(padding, std::streamsize(sectionStart - offset));
+        stream.write(static_cast<const char*>(sections[i].data), std::streamsize(sections[i].size));
+        offset = sectionStart + sections[i].size;
+    }
+
+    stream.close();
+    if (!stream.good() || !file::replace(tempPath, path))
+    {
+        Logger::stream() << "Could not write file: " << path << std::endl;
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+std::shared_ptr<file::MappedFile> MeshContainer::open(const std::string& path, const char (&magic)[4], uint32_t version,
+                                                      void* outTypeHeader, size_t typeHeaderSize, uint64_t& outSourceStamp)
+{
+    auto mappedFile = std::make_shared<file::MappedFile>();
+    if (!mappedFile->open(path) || mappedFile->size() < sizeof(ContainerHeader))
+        return nullptr;
+
+    ContainerHeader header;
+    std::memcpy(&header, mappedFile->data(), sizeof(ContainerHeader));
+
+    if (std::memcmp(header.magic, magic, sizeof(header.magic)) != 0 || header.byteOrderMark != BYTE_ORDER_MARK)
+    {
+        Logger::stream() << "Not a " << std::string(magic, sizeof(header.magic)) << " file of this platform: " << path << std::endl;
+        return nullptr;
+    }
+
+    // Outdated files are silently replaced by the callers
+    if (header.version != version || header.typeHeaderSize != typeHeaderSize ||
+        mappedFile->size() < sizeof(ContainerHeader) + typeHeaderSize)
+        return nullptr;
+
+    std::memcpy(outTypeHeader, mappedFile->data() + sizeof(ContainerHeader), typeHeaderSize);
+    outSourceStamp = header.sourceStamp;
+
+    return mappedFile;
+}
+
+bool MeshContainer::locateSections(const file::MappedFile& mappedFile, size_t typeHeaderSize, const uint64_t* sectionSizes,
+                                   size_t sectionCount, const char** outSections)
+{
+    uint64_t offset = sizeof(ContainerHeader) + typeHeaderSize;
+    for (size_t i = 0; i < sectionCount; ++i)
+    {
+        uint64_t sectionStart = alignSection(offset, SECTION_ALIGNMENT);
+        if (sectionStart > mappedFile.size() || sectionSizes[i] > mappedFile.size() - sectionStart)
+            return false;
+
+        outSections[i] = mappedFile.data() + sectionStart;
+        offset = sectionStart + sectionSizes[i];
+    }
+
+    return offset == mappedFile.size();
+}
+
+bool MeshContainer::validateConnectivity(const IndexType* indices, size_t indexCount, size_t vertexCount, const EdgeID* opposites)
+{
+    EdgeID edgeCount = EdgeID(indexCount);
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        if (indices[i] >= vertexCount)
+            return false;
+
+        if (!opposites)
+            continue;
+
+        EdgeID opposite = opposites[i];
+        if (opposite < BOUNDARY_EDGE || opposite >= edgeCount || (opposite >= 0 && opposites[opposite] != EdgeID(i)))
+            return false;
+
+        // The opposite halfedge connects the same vertices in reverse
+        if (opposite >= 0 && (indices[opposite] != indices[DirectedEdgeMesh::next(EdgeID(i))] ||
+                              indices[DirectedEdgeMesh::next(opposite)] != indices[i]))
+            return false;
+    }
+
+    return true;
+}
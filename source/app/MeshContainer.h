@@ -0,0 +1,65 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <engine/util/file.h>
+#include "DirectedEdgeMesh.h"
+
+/**
+* Binary container of MeshFile and ProgressiveMeshFile that is loaded without parsing:
+* the sections are used in place from the memory mapped file.
+*
+* Layout (native byte order, detected by the header, every section starts at a multiple of SECTION_ALIGNMENT):
+* ContainerHeader | header of the file type | section 0 | section 1 | ...
+*/
+class MeshContainer
+{
+public:
+    static const uint64_t SECTION_ALIGNMENT = 64;
+
+    struct Section
+    {
+        const void* data;
+        uint64_t size;
+    };
+
+    /**
+    * magic and version identify the file type, sourceStamp the source asset the file was created from.
+    * Returns false if the file can't be written.
+    */
+    static bool write(const std::string& path, const char (&magic)[4], uint32_t version, uint64_t sourceStamp,
+                      const void* typeHeader, size_t typeHeaderSize, const Section* sections, size_t sectionCount);
+
+    /**
+    * Maps the file and copies the header of the file type.
+    * Returns nullptr if the file doesn't exist or has a different type, byte order or version.
+    */
+    static std::shared_ptr<file::MappedFile> open(const std::string& path, const char (&magic)[4], uint32_t version,
+                                                  void* outTypeHeader, size_t typeHeaderSize, uint64_t& outSourceStamp);
+
+    /**
+    * Sets outSections[i] to the start of the section with the size sectionSizes[i].
+    * Returns false if the sections don't end exactly at the end of the file.
+    */
+    static bool locateSections(const file::MappedFile& mappedFile, size_t typeHeaderSize, const uint64_t* sectionSizes,
+                               size_t sectionCount, const char** outSections);
+
+    /**
+    * Checks that every index references a vertex and that the opposite halfedges (if not null) are in range,
+    * symmetric and connect the vertices of their halfedge in reverse, so a DirectedEdgeMesh can use them without checks.
+    */
+    static bool validateConnectivity(const IndexType* indices, size_t indexCount, size_t vertexCount, const EdgeID* opposites);
+
+private:
+    struct ContainerHeader
+    {
+        char magic[4];
+        uint32_t version;
+        // Written as BYTE_ORDER_MARK in the byte order of the writer
+        uint32_t byteOrderMark;
+        uint32_t typeHeaderSize;
+        uint64_t sourceStamp;
+    };
+
+    static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+};
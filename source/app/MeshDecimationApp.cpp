@@ -5,8 +5,41 @@
 #include <engine/rendering/Screen.h>
 #include <engine/rendering/util/GLUtil.h>
 #include <engine/resource/AssetImporter.h>
+#include <engine/util/file.h>
+#include <engine/util/Logger.h>
+#include "MeshFile.h"
+#include "ProgressiveMeshFile.h"
 #include <imgui/imgui.h>
 
+namespace
+{
+    /**
+    * Loads the source mesh from the mesh file next to it if that was created from the same source,
+    * otherwise imports it and writes the mesh file for the next start.
+    */
+    std::shared_ptr<ReducibleDirectedEdgeMesh> loadSourceMesh(const std::string& path, uint64_t sourceStamp)
+    {
+        std::string meshCachePath = path + ".mesh";
+        MeshFileData data;
+        if (MeshFile::read(meshCachePath, data) && data.sourceStamp == sourceStamp && data.topology.opposites)
+            return std::make_shared<ReducibleDirectedEdgeMesh>(data.geometry, data.topology);
+
+        // The outdated file is replaced below - Windows can't replace a mapped file
+        data = MeshFileData();
+
+        // Assuming the model has only one sub mesh for simplicity
+        auto model = AssetImporter::importObjPositions(path);
+        if (!model || model->subMeshes.empty() || model->getSubMesh(0).indices.empty())
+            return nullptr;
+
+        model->mapToUnitCube();
+        auto mesh = std::make_shared<ReducibleDirectedEdgeMesh>(model->getSubMesh(0));
+        MeshFile::write(meshCachePath, *mesh, true, sourceStamp);
+
+        return mesh;
+    }
+}
+
 void MeshDecimationApp::initUpdate()
 {
     Input::subscribe(this);
@@ -22,7 +55,8 @@ void MeshDecimationApp::initUpdate()
 
     addMesh("assets/meshes/Sphere.obj", "Sphere");
     addMesh("assets/meshes/bunny.obj", "Stanford Bunny");
-    m_curLoadingMesh = *m_meshes[m_curLoadingMeshIdx].originalEdgeMesh;
+    startReductions();
+    consumeReductionResults();
 
     glEnable(GL_SCISSOR_TEST);
 
@@ -31,19 +65,36 @@ void MeshDecimationApp::initUpdate()
 
 void MeshDecimationApp::addMesh(const std::string& path, const std::string& name)
 {
-    // Assuming the model has only one sub mesh for simplicity
-    auto model = AssetImporter::importObjPositions(path);
-    model->mapToUnitCube();
-    auto reducibleMesh = std::make_shared<ReducibleDirectedEdgeMesh>(model->getSubMesh(0));
-    m_meshes.push_back(MeshWrapper(reducibleMesh, name));
+    std::string cachePath = path + ".pm";
+    uint64_t sourceStamp = file::getStamp(path);
+
+    // The reduction is only computed if there is no up to date progressive mesh file.
+    // The collapses are just replayed (and validated) by ProgressiveMeshBuffers::build(), so the mesh doesn't need a candidate queue.
+    // Importing and building the connectivity otherwise is part of the background reduction.
+    MeshWrapper mesh(nullptr, name);
+    mesh.sourcePath = path;
+    mesh.cachePath = cachePath;
+    mesh.sourceStamp = sourceStamp;
+
+    ProgressiveMeshData data;
+    if (ProgressiveMeshFile::read(cachePath, sourceStamp, data))
+    {
+        mesh.originalEdgeMesh = std::make_shared<ReducibleDirectedEdgeMesh>(data.geometry, data.opposites, data.nonManifoldEdgeCount,
+                                                                            CandidateQueueMode::None);
+        mesh.collapsedEdges.assign(data.collapsedEdges, data.collapsedEdges + data.collapseCount);
+        mesh.collapseErrors.assign(data.collapseErrors, data.collapseErrors + data.collapseCount);
+        mesh.initialized = true;
+    }
+
+    m_meshes.push_back(mesh);
 }
 
 void MeshDecimationApp::update()
 {
     // The full reduction of a mesh is the slowest process and can take a long time on detailed models
-    // -> Don't freeze the program and process all models sequentially with a time constraint.
-    if (size_t(m_curLoadingMeshIdx) < m_meshes.size() && m_meshes.size() > 0)
-        loadCollapsedEdgesCache();
+    // -> The meshes are reduced concurrently in the background and picked up here once they are finished.
+    if (m_reducer.isBusy())
+        consumeReductionResults();
 
     m_modelCamera.updateViewMatrix();
     updateModelRotation();
@@ -66,49 +117,6 @@ void MeshDecimationApp::update()
     handleGUI();
 }
 
-void MeshDecimationApp::createFlatShadedMesh()
-{
-    auto& originalSubMesh = m_phongShadedMesh.getSubMesh(0);
-    auto flatShadedSubMesh = m_phongShadedMesh.getSubMesh(0);
-
-    flatShadedSubMesh.tangents.clear();
-    flatShadedSubMesh.vertices.resize(flatShadedSubMesh.indices.size());
-    flatShadedSubMesh.normals.resize(flatShadedSubMesh.indices.size());
-    flatShadedSubMesh.uvs.clear();
-
-    auto triangleCount = flatShadedSubMesh.indices.size() / 3;
-
-    for (size_t i = 0; i < triangleCount; ++i)
-    {
-        auto idxStart = i * 3;
-
-        auto vi0 = originalSubMesh.indices[idxStart];
-        auto vi1 = originalSubMesh.indices[idxStart + 1];
-        auto vi2 = originalSubMesh.indices[idxStart + 2];
-
-        auto v0 = originalSubMesh.vertices[vi0];
-        auto v1 = originalSubMesh.vertices[vi1];
-        auto v2 = originalSubMesh.vertices[vi2];
-
-        glm::vec3 n = glm::normalize(glm::cross(v1 - v0, v2 - v0));
-
-        flatShadedSubMesh.vertices[idxStart] = v0;
-        flatShadedSubMesh.vertices[idxStart+1] = v1;
-        flatShadedSubMesh.vertices[idxStart+2] = v2;
-
-        flatShadedSubMesh.normals[idxStart] = n;
-        flatShadedSubMesh.normals[idxStart + 1] = n;
-        flatShadedSubMesh.normals[idxStart + 2] = n;
-
-        flatShadedSubMesh.indices[idxStart] = idxStart;
-        flatShadedSubMesh.indices[idxStart+1] = idxStart+1;
-        flatShadedSubMesh.indices[idxStart+2] = idxStart+2;
-    }
-
-    m_flatShadedMesh.setSubMesh(flatShadedSubMesh, 0);
-    m_flatShadedMesh.finalize();
-}
-
 void MeshDecimationApp::onMouseDown(const SDL_MouseButtonEvent& e)
 {
     glm::vec2 pos = glm::vec2(Input::mousePosition);
@@ -132,11 +140,28 @@ void MeshDecimationApp::selectMesh(int meshIdx)
 
     m_curMesh = &m_meshes[meshIdx];
 
-    m_reducibleMesh = *m_curMesh->originalEdgeMesh;
+    // The slider moves between levels of detail by patching the indices of the progressive buffers
+    if (!ProgressiveMeshBuffers::build(*m_curMesh->originalEdgeMesh, m_curMesh->collapsedEdges.data(),
+                                       m_curMesh->collapsedEdges.size(), m_progressiveBuffers))
+    {
+        // Only the sequence of a progressive mesh file can be invalid -> reduce the mesh again and select it once it's done
+        Logger::stream() << "Invalid collapse sequence in " << m_curMesh->cachePath << ", reducing the mesh again" << std::endl;
+        m_curMesh->originalEdgeMesh.reset();
+        m_curMesh->collapsedEdges.clear();
+        m_curMesh->collapseErrors.clear();
+        m_curMesh->initialized = false;
+        startReduction(size_t(meshIdx));
+
+        m_curMesh = nullptr;
+        m_meshSelection = -1;
+        return;
+    }
 
-    m_phongShadedMesh.setSubMesh(m_reducibleMesh.getReducedSubMesh(), 0);
+    m_phongShadedMesh.setSubMesh(m_progressiveBuffers.getSubMesh(), 0);
     m_phongShadedMesh.finalize();
-    createFlatShadedMesh();
+    m_flatShadedMesh = Mesh();
+    m_flatShadedMesh.setSubMesh(m_progressiveBuffers.getFlatShadedSubMesh(), 0);
+    m_flatShadedMesh.finalize();
 
     selectShading(m_shadingSelection);
 
@@ -158,36 +183,52 @@ void MeshDecimationApp::selectShading(int selection)
     }
 }
 
-void MeshDecimationApp::loadCollapsedEdgesCache()
+void MeshDecimationApp::startReductions()
 {
-    float maxAllowedLoadingTimePerFrame = 0.016f; // 16ms
-
-    Timer timer;
-    std::vector<EdgeID>& collapsedEdges = m_meshes[m_curLoadingMeshIdx].collapsedEdges;
-
-    while (timer.totalTime() < maxAllowedLoadingTimePerFrame)
+    for (size_t i = 0; i < m_meshes.size(); ++i)
     {
-        EdgeID collapsedEdge = m_curLoadingMesh.reduce();
-        if (collapsedEdge < 0)
-            break;
-
-        collapsedEdges.push_back(collapsedEdge);
-        timer.tick();
+        if (!m_meshes[i].initialized)
+            startReduction(i);
     }
+}
 
-    if (m_curLoadingMesh.reachedMaxReduction())
+void MeshDecimationApp::startReduction(size_t meshIdx)
+{
+    auto& mesh = m_meshes[meshIdx];
+    std::string sourcePath = mesh.sourcePath;
+    uint64_t sourceStamp = mesh.sourceStamp;
+    m_reducer.start(meshIdx, [sourcePath, sourceStamp]() { return loadSourceMesh(sourcePath, sourceStamp); }, mesh.cachePath, sourceStamp);
+}
+
+void MeshDecimationApp::consumeReductionResults()
+{
+    m_reducer.consumeResults([this](MeshReductionResult& result)
     {
-        m_meshes[m_curLoadingMeshIdx].initialized = true;
+        auto& mesh = m_meshes[result.meshIdx];
+        if (!result.originalMesh)
+        {
+            Logger::stream() << "Could not load " << mesh.sourcePath << std::endl;
+            mesh.loadFailed = true;
+            return;
+        }
 
-        ++m_curLoadingMeshIdx;
-        if (size_t(m_curLoadingMeshIdx) < m_meshes.size())
-            m_curLoadingMesh = *m_meshes[m_curLoadingMeshIdx].originalEdgeMesh;
+        mesh.originalEdgeMesh = std::move(result.originalMesh);
+        mesh.collapsedEdges = std::move(result.collapsedEdges);
+        mesh.collapseErrors = std::move(result.collapseErrors);
+        mesh.initialized = true;
+    });
 
-        if (m_meshSelection < 0)
+    if (m_meshSelection >= 0)
+        return;
+
+    for (size_t i = 0; i < m_meshes.size(); ++i)
+    {
+        if (m_meshes[i].initialized)
         {
-            m_meshSelection = 0;
-            selectMesh(0);
-        }   
+            m_meshSelection = int(i);
+            selectMesh(m_meshSelection);
+            return;
+        }
     }
 }
 
@@ -259,7 +300,7 @@ void MeshDecimationApp::guiMeshSelection()
     for (size_t i = 0; i < m_meshes.size(); ++i)
         guiMeshRadioButton(int(i));
 
-    if (m_curLoadingMeshIdx == 0)
+    if (!m_curMesh)
         return;
 
     if (m_meshSelection != lastSelection)
@@ -274,9 +315,12 @@ void MeshDecimationApp::guiMeshRadioButton(int meshIdx)
     auto& mesh = m_meshes[meshIdx];
     if (mesh.initialized)
         ImGui::RadioButton(mesh.name.c_str(), &m_meshSelection, meshIdx);
+    else if (mesh.loadFailed)
+        ImGui::Text("Could not load %s", mesh.name.c_str());
     else
     {
-        std::string loadingMsg = "Processing " + mesh.name + " ...";
+        int percent = int(100.0f * m_reducer.getProgress(size_t(meshIdx)));
+        std::string loadingMsg = "Processing " + mesh.name + " ... " + std::to_string(percent) + "%";
         ImGui::Text(loadingMsg.c_str(), "%s");
     } 
 }
@@ -306,11 +350,10 @@ static void ShowHelpMarker(const char* desc)
 
 void MeshDecimationApp::guiVertexCountSlider()
 {
-    if (m_curLoadingMeshIdx == 0)
+    if (!m_curMesh)
         return;
 
     ImGui::Text("- Vertex Count -");
-    auto& collapsedEdges = m_curMesh->collapsedEdges;
     int maxVertexCount = int(m_curMesh->originalEdgeMesh->getVertices().size());
     int minVertexCount = int(maxVertexCount - m_curMesh->collapsedEdges.size());
     ImGui::SliderInt("", &m_curVertexCount, minVertexCount, maxVertexCount);
@@ -321,18 +364,22 @@ void MeshDecimationApp::guiVertexCountSlider()
     int reductionCount = maxVertexCount - m_curVertexCount;
 
     // To allow interactive speeds collapse candidates are cached for each mesh during program startup.
-    // Upon slider interaction the original mesh is restored and reduced to the desired vertex count.
-    // This is still an expensive process and won't work interactively for meshes with millions of vertices.
+    // Upon slider interaction only the indices changed by the collapses between the current and the desired
+    // vertex count are uploaded and the draw range is adjusted.
     if (lastVertexCount != m_curVertexCount)
     {
-        m_reducibleMesh = *m_curMesh->originalEdgeMesh;
+        m_progressiveBuffers.setCollapseCount(size_t(reductionCount), m_changedIndexRanges, m_flatShadedChangedIndexRanges);
+
+        auto& indices = m_progressiveBuffers.getSubMesh().indices;
+        for (auto& range : m_changedIndexRanges)
+            m_phongShadedMesh.updateIndices(indices.data() + range.begin, range.begin, range.end - range.begin, 0);
 
-        for (int i = 0; i < reductionCount; ++i)
-            m_reducibleMesh.collapse(collapsedEdges[i]);
+        auto& flatShadedIndices = m_progressiveBuffers.getFlatShadedSubMesh().indices;
+        for (auto& range : m_flatShadedChangedIndexRanges)
+            m_flatShadedMesh.updateIndices(flatShadedIndices.data() + range.begin, range.begin, range.end - range.begin, 0);
 
-        m_phongShadedMesh.setSubMesh(m_reducibleMesh.getReducedSubMesh(), 0);
-        m_phongShadedMesh.finalize();
-        createFlatShadedMesh();
+        m_phongShadedMesh.setDrawIndexCount(m_progressiveBuffers.getIndexCount(), 0);
+        m_flatShadedMesh.setDrawIndexCount(m_progressiveBuffers.getIndexCount(), 0);
         lastVertexCount = m_curVertexCount;
     }
 }
@@ -341,9 +388,9 @@ void MeshDecimationApp::guiShowStats()
 {
     ImGui::NewLine();
 
-    if (m_curLoadingMeshIdx != 0)
+    if (m_curMesh)
     {
-        std::string triangleStr = "Triangles: " + std::to_string(m_reducibleMesh.getFaceCount());
+        std::string triangleStr = "Triangles: " + std::to_string(m_progressiveBuffers.getIndexCount() / 3);
         ImGui::Text(triangleStr.c_str(), "%s");
     }
 
@@ -5,6 +5,8 @@
 #include <engine/rendering/shader/Shader.h>
 #include <engine/input/Input.h>
 #include "ReducibleDirectedEdgeMesh.h"
+#include "ProgressiveMeshBuffers.h"
+#include "BackgroundMeshReducer.h"
 #include <engine/resource/Model.h>
 #include <engine/util/Timer.h>
 
@@ -15,10 +17,19 @@ struct MeshWrapper
     MeshWrapper(std::shared_ptr<ReducibleDirectedEdgeMesh> originalEdgeMesh, const std::string& name)
         :originalEdgeMesh(originalEdgeMesh), name(name) {}
 
+    // Built by the background reducer if the mesh has no up to date progressive mesh file
     std::shared_ptr<ReducibleDirectedEdgeMesh> originalEdgeMesh;
     std::vector<EdgeID> collapsedEdges;
+    std::vector<float> collapseErrors;
     bool initialized{ false };
+    // The background reduction couldn't load the source asset
+    bool loadFailed{ false };
     std::string name;
+
+    // The source asset, the progressive mesh file of the reduction and the stamp of the source asset it belongs to
+    std::string sourcePath;
+    std::string cachePath;
+    uint64_t sourceStamp{ 0 };
 };
 
 class MeshDecimationApp : public Application, InputHandler
@@ -27,8 +38,6 @@ protected:
     void update() override;
     void initUpdate() override;
 
-    void createFlatShadedMesh();
-
     void onMouseDown(const SDL_MouseButtonEvent& e) override;
     void onMousewheel(float delta) override;
 
@@ -36,7 +45,12 @@ private:
     void addMesh(const std::string& path, const std::string& name);
     void selectMesh(int meshIdx);
     void selectShading(int selection);
-    void loadCollapsedEdgesCache();
+    // Starts the background reduction of every mesh that isn't initialized yet.
+    void startReductions();
+    // Imports or loads the mesh and reduces it in the background.
+    void startReduction(size_t meshIdx);
+    // Takes over the finished reductions and selects the first initialized mesh.
+    void consumeReductionResults();
 
     void handleGUI();
     void guiMeshSelection();
@@ -54,8 +68,11 @@ private:
     std::vector<MeshWrapper> m_meshes;
     MeshWrapper* m_curMesh{ nullptr };
 
-    ReducibleDirectedEdgeMesh m_curLoadingMesh;
-    ReducibleDirectedEdgeMesh m_reducibleMesh;
+    BackgroundMeshReducer m_reducer;
+    ProgressiveMeshBuffers m_progressiveBuffers;
+    // Index ranges changed by the last level of detail switch, kept to reuse the memory
+    std::vector<ProgressiveMeshBuffers::IndexRange> m_changedIndexRanges;
+    std::vector<ProgressiveMeshBuffers::IndexRange> m_flatShadedChangedIndexRanges;
     Mesh* m_activeMesh{ nullptr };
     Mesh m_phongShadedMesh;
     Mesh m_flatShadedMesh;
@@ -67,7 +84,6 @@ private:
     int m_curVertexCount{ 0 };
     int m_shadingSelection{ 0 };
     int m_meshSelection{ -1 };
-    int m_curLoadingMeshIdx{ 0 };
 
     glm::quat m_modelRotation;
     glm::quat m_modelRotationBeforeDrag;
@@ -0,0 +1,175 @@
+#include "MeshFile.h"
+#include "MeshContainer.h"
+#include <cstring>
+#include <limits>
+#include <engine/util/file.h>
+#include <engine/util/Logger.h>
+
+namespace
+{
+    const char MAGIC[4] = { 'D', 'E', 'M', 'F' };
+
+    static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "Positions are stored as 3 floats");
+    static_assert(sizeof(IndexType) == sizeof(uint32_t), "Indices are stored as uint32");
+    static_assert(sizeof(HalfedgeVertex) == 2 * sizeof(int32_t), "Vertices are stored as 2 int32");
+    static_assert(sizeof(BorderEdgeList) == 3 * sizeof(uint32_t), "Border edge lists are stored as 3 uint32");
+}
+
+bool MeshFile::write(const std::string& path, const Mesh::SubMesh& subMesh, uint64_t sourceStamp)
+{
+    Header header;
+    std::memset(&header, 0, sizeof(Header));
+    header.vertexCount = subMesh.vertices.size();
+    header.indexCount = subMesh.indices.size();
+
+    MeshContainer::Section sections[] = {
+        { subMesh.vertices.data(), subMesh.vertices.size() * sizeof(glm::vec3) },
+        { subMesh.indices.data(), subMesh.indices.size() * sizeof(IndexType) }
+    };
+
+    return MeshContainer::write(path, MAGIC, VERSION, sourceStamp, &header, sizeof(Header), sections, 2);
+}
+
+bool MeshFile::write(const std::string& path, const DirectedEdgeMesh& mesh, bool includeTopology, uint64_t sourceStamp)
+{
+    auto& geometry = mesh.getGeometry();
+    auto& edges = mesh.getEdges();
+
+    Header header;
+    std::memset(&header, 0, sizeof(Header));
+    header.vertexCount = geometry.vertexCount;
+    header.indexCount = geometry.indexCount;
+
+    MeshContainer::Section sections[] = {
+        { geometry.positions, geometry.vertexCount * sizeof(glm::vec3) },
+        { geometry.indices, geometry.indexCount * sizeof(IndexType) },
+        { nullptr, 0 },
+        { mesh.getVertices().data(), mesh.getVertices().size() * sizeof(HalfedgeVertex) },
+        { mesh.getBorderEdgeLists().data(), mesh.getBorderEdgeLists().size() * sizeof(BorderEdgeList) },
+        { mesh.getBorderEmanatingEdges().data(), mesh.getBorderEmanatingEdges().size() * sizeof(EdgeID) }
+    };
+
+    if (!includeTopology)
+        return MeshContainer::write(path, MAGIC, VERSION, sourceStamp, &header, sizeof(Header), sections, 2);
+
+    std::vector<EdgeID> opposites(edges.size());
+    for (size_t i = 0; i < edges.size(); ++i)
+        opposites[i] = edges[i].opposite;
+
+    sections[2] = { opposites.data(), opposites.size() * sizeof(EdgeID) };
+
+    header.sections = OPPOSITES | BORDER_LISTS;
+    header.nonManifoldEdgeCount = mesh.getNonManifoldEdgeCount();
+    header.borderEdgeListCount = mesh.getBorderEdgeLists().size();
+    header.borderEmanatingEdgeCount = mesh.getBorderEmanatingEdges().size();
+
+    return MeshContainer::write(path, MAGIC, VERSION, sourceStamp, &header, sizeof(Header), sections, 6);
+}
+
+bool MeshFile::read(const std::string& path, MeshFileData& outData)
+{
+    Header header;
+    uint64_t sourceStamp = 0;
+    auto mappedFile = MeshContainer::open(path, MAGIC, VERSION, &header, sizeof(Header), sourceStamp);
+    if (!mappedFile)
+        return false;
+
+    bool hasOpposites = (header.sections & OPPOSITES) != 0;
+    bool hasBorderLists = (header.sections & BORDER_LISTS) != 0;
+
+    // Counts are limited to the range of the index types before any size is computed from them
+    const uint64_t maxCount = uint64_t(std::numeric_limits<EdgeID>::max());
+    bool validCounts = header.vertexCount > 0 && header.vertexCount <= maxCount &&
+                       header.indexCount > 0 && header.indexCount <= maxCount && header.indexCount % 3 == 0 &&
+                       header.borderEdgeListCount <= header.vertexCount && header.borderEmanatingEdgeCount <= maxCount &&
+                       (!hasBorderLists || hasOpposites);
+
+    uint64_t sectionSizes[] = {
+        header.vertexCount * sizeof(glm::vec3),
+        header.indexCount * sizeof(IndexType),
+        header.indexCount * sizeof(EdgeID),
+        header.vertexCount * sizeof(HalfedgeVertex),
+        header.borderEdgeListCount * sizeof(BorderEdgeList),
+        header.borderEmanatingEdgeCount * sizeof(EdgeID)
+    };
+
+    const char* sectionData[6] = {};
+    size_t sectionCount = hasBorderLists ? 6 : (hasOpposites ? 3 : 2);
+
+    if (!validCounts || !MeshContainer::locateSections(*mappedFile, sizeof(Header), sectionSizes, sectionCount, sectionData))
+    {
+        Logger::stream() << "Corrupt mesh file: " << path << std::endl;
+        return false;
+    }
+
+    auto positions = reinterpret_cast<const glm::vec3*>(sectionData[0]);
+    auto indices = reinterpret_cast<const IndexType*>(sectionData[1]);
+    auto opposites = reinterpret_cast<const EdgeID*>(sectionData[2]);
+    auto vertices = reinterpret_cast<const HalfedgeVertex*>(sectionData[3]);
+    auto borderEdgeLists = reinterpret_cast<const BorderEdgeList*>(sectionData[4]);
+    auto borderEmanatingEdges = reinterpret_cast<const EdgeID*>(sectionData[5]);
+
+    // The mesh indexes with these values without checks
+    EdgeID edgeCount = EdgeID(header.indexCount);
+    bool valid = MeshContainer::validateConnectivity(indices, size_t(header.indexCount), size_t(header.vertexCount), opposites);
+
+    for (size_t i = 0; i < header.borderEdgeListCount && valid; ++i)
+    {
+        auto& list = borderEdgeLists[i];
+        valid = list.count <= list.capacity && uint64_t(list.offset) + list.capacity <= header.borderEmanatingEdgeCount;
+    }
+
+    for (size_t i = 0; i < header.vertexCount && valid && hasBorderLists; ++i)
+    {
+        auto& v = vertices[i];
+        // Vertices that aren't referenced by a face keep the invalid edge. The edge of a vertex starts at it.
+        valid = (v.edgeID == INVALID_EDGE_ID || (v.edgeID >= 0 && v.edgeID < edgeCount && indices[v.edgeID] == i)) &&
+                (v.id >= 0 || uint64_t(-int64_t(v.id) - 1) < header.borderEdgeListCount);
+
+        if (!valid || v.id >= 0)
+            continue;
+
+        // The emanating edges of a border vertex start at it
+        auto& list = borderEdgeLists[-v.id - 1];
+        for (uint32_t j = 0; j < list.count && valid; ++j)
+        {
+            EdgeID e = borderEmanatingEdges[list.offset + j];
+            valid = e >= 0 && e < edgeCount && indices[e] == i;
+        }
+    }
+
+    // Every referenced vertex has an edge and the start vertices of border halfedges are border vertices -
+    // the circulation around an inner vertex steps over opposite halfedges without checks
+    for (size_t i = 0; i < header.indexCount && valid && hasBorderLists; ++i)
+    {
+        auto& v = vertices[indices[i]];
+        valid = v.edgeID != INVALID_EDGE_ID && (opposites[i] >= 0 || v.id < 0);
+    }
+
+    if (!valid)
+    {
+        Logger::stream() << "Corrupt mesh file: " << path << std::endl;
+        return false;
+    }
+
+    outData.geometry = GeometryView(positions, size_t(header.vertexCount), indices, size_t(header.indexCount), mappedFile);
+    outData.topology = TopologyView();
+    outData.sourceStamp = sourceStamp;
+
+    if (hasOpposites)
+    {
+        outData.topology.opposites = opposites;
+        outData.topology.nonManifoldEdgeCount = size_t(header.nonManifoldEdgeCount);
+    }
+
+    if (hasBorderLists)
+    {
+        outData.topology.vertices = vertices;
+        outData.topology.borderEdgeLists = borderEdgeLists;
+        outData.topology.borderEdgeListCount = size_t(header.borderEdgeListCount);
+        outData.topology.borderEmanatingEdges = borderEmanatingEdges;
+        outData.topology.borderEmanatingEdgeCount = size_t(header.borderEmanatingEdgeCount);
+    }
+
+    return true;
+}
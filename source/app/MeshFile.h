@@ -0,0 +1,66 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include "DirectedEdgeMesh.h"
+
+/**
+* Contents of a mesh file. The arrays point into the memory mapped file which is kept alive by geometry.owner.
+* The topology arrays are null if the file doesn't contain them.
+*/
+struct MeshFileData
+{
+    GeometryView geometry;
+    TopologyView topology;
+    // Source asset the file was created from (0 if unknown), e.g. to use the file as a cache of an imported asset
+    uint64_t sourceStamp{ 0 };
+};
+
+/**
+* Native mesh file (a MeshContainer): the geometry is used in place and the optional connectivity is copied
+* into a DirectedEdgeMesh instead of being built, so loading a mesh doesn't parse text or match halfedges.
+*
+* Sections: vec3 positions[vertexCount] | uint32 indices[indexCount]
+*         | [int32 opposites[indexCount]]
+*         | [HalfedgeVertex vertices[vertexCount] | BorderEdgeList borderEdgeLists[borderEdgeListCount]
+*         |  int32 borderEmanatingEdges[borderEmanatingEdgeCount]]
+*/
+class MeshFile
+{
+public:
+    static const uint32_t VERSION = 2;
+
+    /**
+    * Writes only the geometry of the sub mesh.
+    */
+    static bool write(const std::string& path, const Mesh::SubMesh& subMesh, uint64_t sourceStamp = 0);
+
+    /**
+    * mesh must not be reduced. The connectivity is only stored if includeTopology is true.
+    * Returns false if the file can't be written.
+    */
+    static bool write(const std::string& path, const DirectedEdgeMesh& mesh, bool includeTopology = true, uint64_t sourceStamp = 0);
+
+    /**
+    * Maps the file and validates the sizes and indices.
+    * Returns false if the file doesn't exist, has a different version or is corrupt.
+    */
+    static bool read(const std::string& path, MeshFileData& outData);
+
+private:
+    enum SectionFlags : uint32_t
+    {
+        OPPOSITES = 1,
+        BORDER_LISTS = 2
+    };
+
+    struct Header
+    {
+        uint32_t sections;
+        uint32_t padding;
+        uint64_t vertexCount;
+        uint64_t indexCount;
+        uint64_t nonManifoldEdgeCount;
+        uint64_t borderEdgeListCount;
+        uint64_t borderEmanatingEdgeCount;
+    };
+};
@@ -0,0 +1,148 @@
+#include "MeshTool.h"
+#include "ReducibleDirectedEdgeMesh.h"
+#include "StreamingSimplifier.h"
+#include <engine/resource/AssetImporter.h>
+#include <engine/resource/AssetExporter.h>
+#include <engine/util/Logger.h>
+#include <cstring>
+#include <cstdlib>
+#include <string>
+
+namespace
+{
+    void printUsage()
+    {
+        Logger::stream() << "Usage: reduce <input> <output> <faceRatio> [--verify]" << std::endl;
+        Logger::stream() << "       stream <input> <output> <gridResolution> [faceRatio]" << std::endl;
+    }
+
+    /**
+    * Imports the written file again - the positions must be read back exactly, so they are compared bit by bit.
+    */
+    bool parseFaceRatio(const char* arg, float& outFaceRatio)
+    {
+        outFaceRatio = float(std::atof(arg));
+        if (outFaceRatio >= 0.0f && outFaceRatio <= 1.0f)
+            return true;
+
+        Logger::stream() << "The face ratio must be in [0, 1]." << std::endl;
+        return false;
+    }
+
+    void reduceToFaceRatio(ReducibleDirectedEdgeMesh& mesh, float faceRatio)
+    {
+        size_t targetFaceCount = size_t(faceRatio * float(mesh.getFaceCount()));
+        while (mesh.getFaceCount() > targetFaceCount && mesh.reduce() >= 0) {}
+    }
+
+    bool verifyExport(const std::string& filename, const Mesh::SubMesh& subMesh)
+    {
+        auto model = filename.find(".obj") != filename.npos ? AssetImporter::importObjPositions(filename) : AssetImporter::import(filename);
+        if (!model || model->subMeshes.empty())
+            return false;
+
+        auto& imported = model->getSubMesh(0);
+        return imported.indices == subMesh.indices && imported.vertices.size() == subMesh.vertices.size() &&
+               std::memcmp(imported.vertices.data(), subMesh.vertices.data(), subMesh.vertices.size() * sizeof(glm::vec3)) == 0;
+    }
+}
+
+bool MeshTool::isCommand(int argc, char** argv)
+{
+    return argc > 1 && (std::strcmp(argv[1], "reduce") == 0 || std::strcmp(argv[1], "stream") == 0);
+}
+
+int MeshTool::run(int argc, char** argv)
+{
+    if (std::strcmp(argv[1], "reduce") == 0)
+        return reduce(argc, argv);
+
+    if (std::strcmp(argv[1], "stream") == 0)
+        return stream(argc, argv);
+
+    printUsage();
+    return 1;
+}
+
+int MeshTool::reduce(int argc, char** argv)
+{
+    bool verify = argc == 6 && std::strcmp(argv[5], "--verify") == 0;
+    if (argc != 5 && !verify)
+    {
+        printUsage();
+        return 1;
+    }
+
+    std::string input = argv[2];
+    std::string output = argv[3];
+    float faceRatio;
+    if (!parseFaceRatio(argv[4], faceRatio))
+        return 1;
+
+    auto model = input.find(".obj") != input.npos ? AssetImporter::importObjPositions(input) : AssetImporter::import(input);
+    if (!model || model->subMeshes.empty() || model->getSubMesh(0).indices.empty())
+    {
+        Logger::stream() << "Could not import " << input << std::endl;
+        return 1;
+    }
+
+    // Assuming the model has only one sub mesh for simplicity
+    ReducibleDirectedEdgeMesh mesh(model->getSubMesh(0));
+    reduceToFaceRatio(mesh, faceRatio);
+
+    Mesh::SubMesh reduced = mesh.getReducedSubMesh();
+    Logger::stream() << "Reduced " << input << " to " << reduced.vertices.size() << " vertices and "
+                     << reduced.indices.size() / 3 << " faces." << std::endl;
+
+    if (!AssetExporter::exportSubMesh(output, reduced))
+        return 1;
+
+    if (verify && !verifyExport(output, reduced))
+    {
+        Logger::stream() << "The exported file " << output << " doesn't match the reduced mesh." << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+int MeshTool::stream(int argc, char** argv)
+{
+    if (argc != 5 && argc != 6)
+    {
+        printUsage();
+        return 1;
+    }
+
+    std::string input = argv[2];
+    std::string output = argv[3];
+    long gridResolution = std::atol(argv[4]);
+    if (gridResolution < 1 || gridResolution > long(StreamingSimplifier::MAX_GRID_RESOLUTION))
+    {
+        Logger::stream() << "The grid resolution must be in [1, " << StreamingSimplifier::MAX_GRID_RESOLUTION << "]." << std::endl;
+        return 1;
+    }
+
+    float faceRatio = 1.0f;
+    if (argc == 6 && !parseFaceRatio(argv[5], faceRatio))
+        return 1;
+
+    Mesh::SubMesh simplified;
+    if (!StreamingSimplifier::simplify(input, uint32_t(gridResolution), simplified))
+    {
+        Logger::stream() << "Could not simplify " << input << std::endl;
+        return 1;
+    }
+
+    // The in-core reduction continues from the clustered mesh
+    ReducibleDirectedEdgeMesh mesh(simplified);
+    Logger::stream() << "Simplified " << input << " to " << simplified.vertices.size() << " vertices and "
+                     << mesh.getFaceCount() << " faces (" << mesh.getNonManifoldEdgeCount() << " non-manifold edges)." << std::endl;
+
+    reduceToFaceRatio(mesh, faceRatio);
+    Mesh::SubMesh reduced = mesh.getReducedSubMesh();
+    if (faceRatio < 1.0f)
+        Logger::stream() << "Reduced it to " << reduced.vertices.size() << " vertices and " << reduced.indices.size() / 3 << " faces." << std::endl;
+
+    return AssetExporter::exportSubMesh(output, reduced) ? 0 : 1;
+}
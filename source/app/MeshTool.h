@@ -0,0 +1,26 @@
+#pragma once
+
+/**
+* Headless command line mode that runs without a window:
+*   reduce <input> <output> <faceRatio> [--verify]
+*   stream <input> <output> <gridResolution> [faceRatio]
+* reduce imports the input (.obj, .ply or .stl), reduces it to at most faceRatio times its faces and exports
+* the result (.obj or .ply, see AssetExporter). With --verify the written file is imported again
+* and compared bit by bit with the exported sub mesh.
+* stream simplifies an input that may not fit into memory (.obj or .stl) with the StreamingSimplifier, loads the
+* result into a ReducibleDirectedEdgeMesh, optionally reduces it further to faceRatio times its faces and exports it.
+*/
+class MeshTool
+{
+public:
+    static bool isCommand(int argc, char** argv);
+
+    /**
+    * Returns the exit code of the process.
+    */
+    static int run(int argc, char** argv);
+
+private:
+    static int reduce(int argc, char** argv);
+    static int stream(int argc, char** argv);
+};
@@ -0,0 +1,280 @@
+#include "ProgressiveMeshBuffers.h"
+#include "ReducibleDirectedEdgeMesh.h"
+#include <algorithm>
+
+bool ProgressiveMeshBuffers::build(const DirectedEdgeMesh& baseMesh, const EdgeID* collapsedEdges, size_t collapseCount,
+                                   ProgressiveMeshBuffers& outBuffers)
+{
+    auto& geometry = baseMesh.getGeometry();
+    auto& baseEdges = baseMesh.getEdges();
+    size_t vertexCount = geometry.vertexCount;
+    size_t faceCount = geometry.getFaceCount();
+
+    // The collapses are replayed on a copy of the connectivity without candidates.
+    // Every collapse is validated first, the sequence might come from a file.
+    std::vector<EdgeID> opposites(baseEdges.size());
+    for (size_t i = 0; i < baseEdges.size(); ++i)
+        opposites[i] = baseEdges[i].opposite;
+
+    ReducibleDirectedEdgeMesh mesh(geometry, opposites.data(), baseMesh.getNonManifoldEdgeCount(), CandidateQueueMode::None);
+    auto& edges = mesh.getEdges();
+
+    ProgressiveMeshBuffers buffers;
+    buffers.m_collapses.resize(collapseCount);
+
+    std::vector<VertexIndex> deletedVertices(collapseCount);
+    std::vector<VertexIndex> remainingVertices(collapseCount);
+    // Collapse that removes the face, collapseCount if it is never removed
+    std::vector<uint32_t> faceRemovals(faceCount, uint32_t(collapseCount));
+    buffers.m_faceCounts.resize(collapseCount + 1);
+    buffers.m_faceCounts[0] = uint32_t(faceCount);
+
+    for (size_t c = 0; c < collapseCount; ++c)
+    {
+        EdgeID ei = collapsedEdges[c];
+        if (ei < 0 || size_t(ei) >= edges.size() || mesh.isFaceRemoved(ei / 3) || !mesh.isValidCollapseCandidate(ei))
+            return false;
+
+        EdgeID opposite = edges[ei].opposite;
+        auto& collapse = buffers.m_collapses[c];
+
+        deletedVertices[c] = edges[ei].vertexIdx;
+        remainingVertices[c] = edges[DirectedEdgeMesh::next(ei)].vertexIdx;
+        faceRemovals[ei / 3] = uint32_t(c);
+        if (opposite >= 0)
+            faceRemovals[opposite / 3] = uint32_t(c);
+
+        buffers.m_faceCounts[c + 1] = buffers.m_faceCounts[c] - (opposite >= 0 ? 2 : 1);
+
+        // The halfedges are stored for now and converted to index buffer positions once the face order is known
+        collapse.cornerOffset = uint32_t(buffers.m_corners.size());
+        mesh.forEachEmanatingEdge(deletedVertices[c], [&](EdgeID e)
+        {
+            if (e / 3 != ei / 3 && (opposite < 0 || e / 3 != opposite / 3))
+                buffers.m_corners.push_back(uint32_t(e));
+        });
+        collapse.cornerCount = uint32_t(buffers.m_corners.size()) - collapse.cornerOffset;
+
+        mesh.collapse(ei);
+    }
+
+    // Faces that are removed later come first. The order of faces removed by the same collapse is kept.
+    std::vector<FaceIndex> faceOrder(faceCount);
+    for (size_t f = 0; f < faceCount; ++f)
+        faceOrder[f] = FaceIndex(f);
+
+    std::stable_sort(faceOrder.begin(), faceOrder.end(), [&faceRemovals](FaceIndex lhs, FaceIndex rhs)
+    {
+        return faceRemovals[lhs] > faceRemovals[rhs];
+    });
+
+    std::vector<uint32_t> facePositions(faceCount);
+    for (size_t i = 0; i < faceCount; ++i)
+        facePositions[faceOrder[i]] = uint32_t(i);
+
+    // Vertices that are never deleted keep their order, deleted vertices follow in reverse collapse order
+    std::vector<IndexType> newVertexIndices(vertexCount, 0);
+    std::vector<uint8_t> deleted(vertexCount, 0);
+    for (size_t c = 0; c < collapseCount; ++c)
+    {
+        newVertexIndices[deletedVertices[c]] = IndexType(vertexCount - 1 - c);
+        deleted[deletedVertices[c]] = 1;
+    }
+
+    IndexType nextIndex = 0;
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        if (!deleted[v])
+            newVertexIndices[v] = nextIndex++;
+    }
+
+    for (size_t c = 0; c < collapseCount; ++c)
+    {
+        buffers.m_collapses[c].deletedVertex = newVertexIndices[deletedVertices[c]];
+        buffers.m_collapses[c].remainingVertex = newVertexIndices[remainingVertices[c]];
+    }
+
+    for (auto& corner : buffers.m_corners)
+        corner = 3 * facePositions[corner / 3] + corner % 3;
+
+    // Indices of the unreduced mesh
+    auto& subMesh = buffers.m_subMesh;
+    subMesh.indices.resize(geometry.indexCount);
+    for (size_t i = 0; i < faceCount; ++i)
+    {
+        for (size_t r = 0; r < 3; ++r)
+            subMesh.indices[3 * i + r] = newVertexIndices[geometry.indices[3 * faceOrder[i] + r]];
+    }
+
+    // Normals of the unreduced mesh, unreferenced vertices have no normal
+    subMesh.vertices.resize(vertexCount);
+    subMesh.normals.resize(vertexCount, glm::vec3(0.0f));
+
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        subMesh.vertices[newVertexIndices[v]] = geometry.positions[v];
+
+        if (baseMesh.getVertices()[v].edgeID != INVALID_EDGE_ID)
+            subMesh.normals[newVertexIndices[v]] = baseMesh.computeVertexNormal(VertexIndex(v));
+    }
+
+    buffers.buildFlatShadedSubMesh();
+    outBuffers = std::move(buffers);
+
+    return true;
+}
+
+void ProgressiveMeshBuffers::buildFlatShadedSubMesh()
+{
+    // The collapses are replayed on a copy of the indices to get the face states
+    Indices indices = m_subMesh.indices;
+    size_t faceCount = indices.size() / 3;
+
+    auto& flatIndices = m_flatShadedSubMesh.indices;
+    flatIndices.resize(indices.size());
+    m_flatShadedSubMesh.vertices.reserve(indices.size() + 3 * m_corners.size());
+    m_flatShadedSubMesh.normals.reserve(indices.size() + 3 * m_corners.size());
+
+    // First flat shaded vertex of the current state of every face
+    std::vector<IndexType> faceVertices(faceCount);
+    for (size_t f = 0; f < faceCount; ++f)
+    {
+        faceVertices[f] = addFlatShadedFace(indices, f);
+        for (size_t r = 0; r < 3; ++r)
+            flatIndices[3 * f + r] = faceVertices[f] + IndexType(r);
+    }
+
+    for (auto& collapse : m_collapses)
+    {
+        collapse.flatShadedChangeOffset = uint32_t(m_flatShadedFaceChanges.size());
+
+        for (uint32_t i = collapse.cornerOffset; i < collapse.cornerOffset + collapse.cornerCount; ++i)
+        {
+            indices[m_corners[i]] = collapse.remainingVertex;
+
+            // A face can have at most two corners in the one-ring of the deleted vertex, the changes of a collapse are few
+            uint32_t facePosition = m_corners[i] / 3;
+            auto changesBegin = m_flatShadedFaceChanges.begin() + collapse.flatShadedChangeOffset;
+            bool known = std::any_of(changesBegin, m_flatShadedFaceChanges.end(), [facePosition](const FlatShadedFaceChange& change)
+            {
+                return change.facePosition == facePosition;
+            });
+
+            if (!known)
+            {
+                FlatShadedFaceChange change;
+                change.facePosition = facePosition;
+                change.firstVertexBefore = faceVertices[facePosition];
+                m_flatShadedFaceChanges.push_back(change);
+            }
+        }
+
+        collapse.flatShadedChangeCount = uint32_t(m_flatShadedFaceChanges.size()) - collapse.flatShadedChangeOffset;
+
+        // The new states are created once all corners of the collapse are moved
+        for (size_t i = collapse.flatShadedChangeOffset; i < m_flatShadedFaceChanges.size(); ++i)
+        {
+            auto& change = m_flatShadedFaceChanges[i];
+            change.firstVertexAfter = addFlatShadedFace(indices, change.facePosition);
+            faceVertices[change.facePosition] = change.firstVertexAfter;
+        }
+    }
+}
+
+IndexType ProgressiveMeshBuffers::addFlatShadedFace(const Indices& indices, size_t faceIdx)
+{
+    auto& vertices = m_flatShadedSubMesh.vertices;
+    auto& normals = m_flatShadedSubMesh.normals;
+    IndexType firstVertex = IndexType(vertices.size());
+
+    auto& v0 = m_subMesh.vertices[indices[3 * faceIdx]];
+    auto& v1 = m_subMesh.vertices[indices[3 * faceIdx + 1]];
+    auto& v2 = m_subMesh.vertices[indices[3 * faceIdx + 2]];
+
+    // Degenerate faces keep a zero normal
+    glm::vec3 n = glm::cross(v1 - v0, v2 - v0);
+    float length = glm::length(n);
+    if (length > 0.0f)
+        n /= length;
+
+    vertices.push_back(v0);
+    vertices.push_back(v1);
+    vertices.push_back(v2);
+    normals.insert(normals.end(), 3, n);
+
+    return firstVertex;
+}
+
+void ProgressiveMeshBuffers::setCollapseCount(size_t collapseCount, std::vector<IndexRange>& outChanged,
+                                              std::vector<IndexRange>& outFlatShadedChanged)
+{
+    assert(collapseCount <= m_collapses.size());
+
+    auto& indices = m_subMesh.indices;
+    auto& flatIndices = m_flatShadedSubMesh.indices;
+    m_changedPositions.clear();
+    m_flatShadedChangedPositions.clear();
+
+    auto setCorners = [&](const Collapse& collapse, IndexType vertex)
+    {
+        for (uint32_t i = collapse.cornerOffset; i < collapse.cornerOffset + collapse.cornerCount; ++i)
+        {
+            indices[m_corners[i]] = vertex;
+            m_changedPositions.push_back(m_corners[i]);
+        }
+    };
+
+    auto setFlatShadedFaces = [&](const Collapse& collapse, bool applied)
+    {
+        for (uint32_t i = collapse.flatShadedChangeOffset; i < collapse.flatShadedChangeOffset + collapse.flatShadedChangeCount; ++i)
+        {
+            auto& change = m_flatShadedFaceChanges[i];
+            IndexType firstVertex = applied ? change.firstVertexAfter : change.firstVertexBefore;
+            for (IndexType r = 0; r < 3; ++r)
+            {
+                flatIndices[3 * change.facePosition + r] = firstVertex + r;
+                m_flatShadedChangedPositions.push_back(3 * change.facePosition + r);
+            }
+        }
+    };
+
+    // Later collapses can change the same corners again -> they are undone in reverse order
+    for (; m_curCollapseCount < collapseCount; ++m_curCollapseCount)
+    {
+        auto& collapse = m_collapses[m_curCollapseCount];
+        setCorners(collapse, collapse.remainingVertex);
+        setFlatShadedFaces(collapse, true);
+    }
+
+    for (; m_curCollapseCount > collapseCount; --m_curCollapseCount)
+    {
+        auto& collapse = m_collapses[m_curCollapseCount - 1];
+        setCorners(collapse, collapse.deletedVertex);
+        setFlatShadedFaces(collapse, false);
+    }
+
+    mergeChangedPositions(m_changedPositions, outChanged);
+    mergeChangedPositions(m_flatShadedChangedPositions, outFlatShadedChanged);
+}
+
+void ProgressiveMeshBuffers::mergeChangedPositions(std::vector<uint32_t>& positions, std::vector<IndexRange>& outRanges)
+{
+    // Unchanged indices between two changes are uploaded with them if that is cheaper than another upload call
+    const uint32_t MAX_GAP = 16;
+
+    outRanges.clear();
+    std::sort(positions.begin(), positions.end());
+
+    for (uint32_t position : positions)
+    {
+        if (!outRanges.empty() && position <= outRanges.back().end + MAX_GAP)
+            outRanges.back().end = std::max(outRanges.back().end, size_t(position) + 1);
+        else
+        {
+            IndexRange range;
+            range.begin = position;
+            range.end = size_t(position) + 1;
+            outRanges.push_back(range);
+        }
+    }
+}
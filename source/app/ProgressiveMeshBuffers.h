@@ -0,0 +1,97 @@
+#pragma once
+#include <vector>
+#include "DirectedEdgeMesh.h"
+
+/**
+* Vertex and index buffers of all levels of detail of a collapse sequence in one static layout
+* (similar to the progressive mesh buffers of Hugues Hoppe):
+* - Vertices are sorted in reverse collapse order -> the mesh after k collapses uses the first vertexCount - k vertices.
+* - Faces are sorted by the collapse that removes them, faces that are never removed come first
+*   -> every level of detail draws a prefix of the index buffer.
+* A collapse only changes the corners of its deleted vertex in the remaining faces. These corners are
+* stored per collapse, so switching the level of detail changes the draw range and patches O(valence) indices
+* per collapse in place instead of rebuilding the mesh.
+* The flat shaded buffers use the same face order. Every state of a face that a collapse changes gets its own three
+* vertices with the face normal, so flat shading switches between levels of detail by patching indices as well.
+*/
+class ProgressiveMeshBuffers
+{
+public:
+    // Range [begin, end) of an index buffer
+    struct IndexRange
+    {
+        bool empty() const { return begin >= end; }
+
+        size_t begin{ 0 };
+        size_t end{ 0 };
+    };
+
+    /**
+    * baseMesh must not be reduced. The collapsed edges are collapsed in the given order - e.g. the edges returned by reduce().
+    * Returns false if one of them isn't a valid collapse at its turn (e.g. the sequence of a corrupt progressive mesh file).
+    */
+    static bool build(const DirectedEdgeMesh& baseMesh, const EdgeID* collapsedEdges, size_t collapseCount,
+                      ProgressiveMeshBuffers& outBuffers);
+
+    /**
+    * Applies or undoes collapses until collapseCount collapses are applied.
+    * Returns the sorted, disjoint ranges of changed indices of the smooth and the flat shaded sub mesh
+    * which are empty if nothing changed. Nearby changes share a range to keep the number of uploads small.
+    */
+    void setCollapseCount(size_t collapseCount, std::vector<IndexRange>& outChanged, std::vector<IndexRange>& outFlatShadedChanged);
+
+    size_t getCollapseCount() const { return m_curCollapseCount; }
+    size_t getMaxCollapseCount() const { return m_collapses.size(); }
+    size_t getIndexCount() const { return 3 * m_faceCounts[m_curCollapseCount]; }
+    size_t getVertexCount() const { return m_subMesh.vertices.size() - m_curCollapseCount; }
+
+    /**
+    * Positions and normals of the unreduced mesh in the permuted order and the indices of the current level of detail.
+    */
+    const Mesh::SubMesh& getSubMesh() const { return m_subMesh; }
+
+    /**
+    * Three vertices with the face normal per face state and the indices of the current level of detail.
+    * The index count is the same as the one of getSubMesh().
+    */
+    const Mesh::SubMesh& getFlatShadedSubMesh() const { return m_flatShadedSubMesh; }
+
+private:
+    void buildFlatShadedSubMesh();
+    static void mergeChangedPositions(std::vector<uint32_t>& positions, std::vector<IndexRange>& outRanges);
+    IndexType addFlatShadedFace(const Indices& indices, size_t faceIdx);
+
+    struct Collapse
+    {
+        // Range in m_corners
+        uint32_t cornerOffset{ 0 };
+        uint32_t cornerCount{ 0 };
+        IndexType deletedVertex{ 0 };
+        IndexType remainingVertex{ 0 };
+        // Range in m_flatShadedFaceChanges
+        uint32_t flatShadedChangeOffset{ 0 };
+        uint32_t flatShadedChangeCount{ 0 };
+    };
+
+    // A face whose corners are changed by a collapse switches from the flat shaded vertices before to the ones after it
+    struct FlatShadedFaceChange
+    {
+        uint32_t facePosition{ 0 };
+        IndexType firstVertexBefore{ 0 };
+        IndexType firstVertexAfter{ 0 };
+    };
+
+    Mesh::SubMesh m_subMesh;
+    std::vector<Collapse> m_collapses;
+    // Positions in the index buffer that reference the deleted vertex of a collapse
+    std::vector<uint32_t> m_corners;
+    Mesh::SubMesh m_flatShadedSubMesh;
+    std::vector<FlatShadedFaceChange> m_flatShadedFaceChanges;
+    // The index into the vector corresponds to the number of collapses.
+    std::vector<uint32_t> m_faceCounts;
+    size_t m_curCollapseCount{ 0 };
+
+    // Changed index buffer positions of the last setCollapseCount() call, kept to reuse the memory
+    std::vector<uint32_t> m_changedPositions;
+    std::vector<uint32_t> m_flatShadedChangedPositions;
+};
@@ -0,0 +1,98 @@
+#include "ProgressiveMeshFile.h"
+#include "MeshContainer.h"
+#include <cstring>
+#include <engine/util/file.h>
+#include <engine/util/Logger.h>
+
+namespace
+{
+    const char MAGIC[4] = { 'P', 'M', 'S', 'H' };
+
+    static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "Positions are stored as 3 floats");
+    static_assert(sizeof(IndexType) == sizeof(uint32_t), "Indices are stored as uint32");
+}
+
+bool ProgressiveMeshFile::write(const std::string& path, const DirectedEdgeMesh& baseMesh, const std::vector<EdgeID>& collapsedEdges,
+                                const std::vector<float>& collapseErrors, uint64_t sourceStamp)
+{
+    assert(collapsedEdges.size() == collapseErrors.size());
+
+    auto& geometry = baseMesh.getGeometry();
+    auto& edges = baseMesh.getEdges();
+
+    Header header;
+    std::memset(&header, 0, sizeof(Header));
+    header.vertexCount = uint32_t(geometry.vertexCount);
+    header.indexCount = uint32_t(geometry.indexCount);
+    header.collapseCount = uint32_t(collapsedEdges.size());
+    header.nonManifoldEdgeCount = baseMesh.getNonManifoldEdgeCount();
+
+    std::vector<EdgeID> opposites(edges.size());
+    for (size_t i = 0; i < edges.size(); ++i)
+        opposites[i] = edges[i].opposite;
+
+    MeshContainer::Section sections[] = {
+        { geometry.positions, geometry.vertexCount * sizeof(glm::vec3) },
+        { geometry.indices, geometry.indexCount * sizeof(IndexType) },
+        { opposites.data(), opposites.size() * sizeof(EdgeID) },
+        { collapsedEdges.data(), collapsedEdges.size() * sizeof(EdgeID) },
+        { collapseErrors.data(), collapseErrors.size() * sizeof(float) }
+    };
+
+    return MeshContainer::write(path, MAGIC, VERSION, sourceStamp, &header, sizeof(Header), sections, 5);
+}
+
+bool ProgressiveMeshFile::read(const std::string& path, uint64_t sourceStamp, ProgressiveMeshData& outData)
+{
+    Header header;
+    uint64_t fileSourceStamp = 0;
+    auto mappedFile = MeshContainer::open(path, MAGIC, VERSION, &header, sizeof(Header), fileSourceStamp);
+
+    // Outdated files are silently replaced by the caller
+    if (!mappedFile || fileSourceStamp != sourceStamp)
+        return false;
+
+    uint64_t sectionSizes[] = {
+        uint64_t(header.vertexCount) * sizeof(glm::vec3),
+        uint64_t(header.indexCount) * sizeof(IndexType),
+        uint64_t(header.indexCount) * sizeof(EdgeID),
+        uint64_t(header.collapseCount) * sizeof(EdgeID),
+        uint64_t(header.collapseCount) * sizeof(float)
+    };
+
+    const char* sectionData[5] = {};
+    bool validCounts = header.vertexCount > 0 && header.indexCount > 0 && header.indexCount % 3 == 0;
+
+    if (!validCounts || !MeshContainer::locateSections(*mappedFile, sizeof(Header), sectionSizes, 5, sectionData))
+    {
+        Logger::stream() << "Corrupt progressive mesh file: " << path << std::endl;
+        return false;
+    }
+
+    auto positions = reinterpret_cast<const glm::vec3*>(sectionData[0]);
+    auto indices = reinterpret_cast<const IndexType*>(sectionData[1]);
+    auto opposites = reinterpret_cast<const EdgeID*>(sectionData[2]);
+    auto collapsedEdges = reinterpret_cast<const EdgeID*>(sectionData[3]);
+    auto collapseErrors = reinterpret_cast<const float*>(sectionData[4]);
+
+    // The mesh indexes with these values without checks. The collapse sequence itself is expected to come from write().
+    bool valid = MeshContainer::validateConnectivity(indices, header.indexCount, header.vertexCount, opposites);
+
+    for (size_t i = 0; i < header.collapseCount && valid; ++i)
+        valid = collapsedEdges[i] >= 0 && collapsedEdges[i] < EdgeID(header.indexCount);
+
+    if (!valid)
+    {
+        Logger::stream() << "Corrupt progressive mesh file: " << path << std::endl;
+        return false;
+    }
+
+    outData.geometry = GeometryView(positions, header.vertexCount, indices, header.indexCount, mappedFile);
+    outData.opposites = opposites;
+    outData.nonManifoldEdgeCount = size_t(header.nonManifoldEdgeCount);
+    outData.collapsedEdges = collapsedEdges;
+    outData.collapseErrors = collapseErrors;
+    outData.collapseCount = header.collapseCount;
+
+    return true;
+}
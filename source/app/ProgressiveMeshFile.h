@@ -0,0 +1,59 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "DirectedEdgeMesh.h"
+
+/**
+* Contents of a progressive mesh file. The arrays point into the memory mapped file
+* which is kept alive by geometry.owner.
+*/
+struct ProgressiveMeshData
+{
+    // Base mesh with its halfedge connectivity
+    GeometryView geometry;
+    const EdgeID* opposites{ nullptr };
+    size_t nonManifoldEdgeCount{ 0 };
+
+    // Collapsed edges in reduction order and the geometric error of each collapse.
+    // The vertex splits that refine the reduced mesh again are the collapses in reverse order.
+    const EdgeID* collapsedEdges{ nullptr };
+    const float* collapseErrors{ nullptr };
+    size_t collapseCount{ 0 };
+};
+
+/**
+* Versioned binary file of a precomputed reduction (a MeshContainer), so the reduction of a mesh is computed once
+* offline and every later load only maps the file.
+*
+* Sections: vec3 positions[vertexCount] | uint32 indices[indexCount] | int32 opposites[indexCount]
+*         | int32 collapsedEdges[collapseCount] | float collapseErrors[collapseCount]
+*/
+class ProgressiveMeshFile
+{
+public:
+    static const uint32_t VERSION = 2;
+
+    /**
+    * baseMesh must not be reduced. sourceStamp identifies the source asset (see file::getStamp) - read() rejects files
+    * with a different stamp. Returns false if the file can't be written.
+    */
+    static bool write(const std::string& path, const DirectedEdgeMesh& baseMesh, const std::vector<EdgeID>& collapsedEdges,
+                      const std::vector<float>& collapseErrors, uint64_t sourceStamp);
+
+    /**
+    * Maps the file and validates the sizes and the connectivity of the base mesh.
+    * Returns false if the file doesn't exist, has a different version or source stamp or is corrupt.
+    */
+    static bool read(const std::string& path, uint64_t sourceStamp, ProgressiveMeshData& outData);
+
+private:
+    struct Header
+    {
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        uint32_t collapseCount;
+        uint32_t padding;
+        uint64_t nonManifoldEdgeCount;
+    };
+};
@@ -1,91 +1,636 @@
 #include "ReducibleDirectedEdgeMesh.h"
 #include <algorithm>
-#include <engine/util/set_operations.h>
 
-ReducibleDirectedEdgeMesh::ReducibleDirectedEdgeMesh(const Mesh::SubMesh& subMesh)
-    :DirectedEdgeMesh(subMesh)
+template<class TCostPolicy>
+BasicReducibleDirectedEdgeMesh<TCostPolicy>::BasicReducibleDirectedEdgeMesh(const Mesh::SubMesh& subMesh, CandidateQueueMode queueMode)
+    :BasicReducibleDirectedEdgeMesh(GeometryView::copyFrom(subMesh), queueMode) {}
+
+template<class TCostPolicy>
+BasicReducibleDirectedEdgeMesh<TCostPolicy>::BasicReducibleDirectedEdgeMesh(const GeometryView& geometry, CandidateQueueMode queueMode)
+    :DirectedEdgeMesh(geometry), m_queueMode(queueMode)
+{
+    init();
+}
+
+template<class TCostPolicy>
+BasicReducibleDirectedEdgeMesh<TCostPolicy>::BasicReducibleDirectedEdgeMesh(const GeometryView& geometry, const EdgeID* opposites,
+                                                                            size_t nonManifoldEdgeCount, CandidateQueueMode queueMode)
+    :DirectedEdgeMesh(geometry, opposites, nonManifoldEdgeCount), m_queueMode(queueMode)
+{
+    init();
+}
+
+template<class TCostPolicy>
+BasicReducibleDirectedEdgeMesh<TCostPolicy>::BasicReducibleDirectedEdgeMesh(const GeometryView& geometry, const TopologyView& topology,
+                                                                            CandidateQueueMode queueMode)
+    :DirectedEdgeMesh(geometry, topology), m_queueMode(queueMode)
+{
+    init();
+}
+
+template<class TCostPolicy>
+void BasicReducibleDirectedEdgeMesh<TCostPolicy>::init()
 {
     m_removedFaces.resize(m_edges.size() / 3);
     std::fill(m_removedFaces.begin(), m_removedFaces.end(), false);
 
-    initCollapseCandidates();
+    initFaceNormals();
+    initValences();
+    initNonManifoldVertices();
+    m_costPolicy.init(*this);
+    resetCollapseCandidates();
 }
 
-void ReducibleDirectedEdgeMesh::initCollapseCandidates()
+template<class TCostPolicy>
+void BasicReducibleDirectedEdgeMesh<TCostPolicy>::initFaceNormals()
 {
-    m_costs.resize(m_edges.size());
+    m_faceNormals.resize(m_edges.size() / 3);
+
+    for (size_t i = 0; i < m_faceNormals.size(); ++i)
+        m_faceNormals[i] = computeFaceNormal(FaceIndex(i));
+}
 
+template<class TCostPolicy>
+void BasicReducibleDirectedEdgeMesh<TCostPolicy>::initValences()
+{
+    m_valences.resize(m_vertices.size());
+
+    for (size_t i = 0; i < m_valences.size(); ++i)
+        m_valences[i] = valenceOf(VertexIndex(i));
+}
+
+template<class TCostPolicy>
+void BasicReducibleDirectedEdgeMesh<TCostPolicy>::initNonManifoldVertices()
+{
+    m_nonManifoldVertices.clear();
+    if (m_nonManifoldEdgeCount == 0)
+        return;
+
+    // The halfedges of a non-manifold edge are border halfedges with the same vertex pair
+    std::vector<uint64_t> borderVertexPairs;
     for (size_t i = 0; i < m_edges.size(); ++i)
     {
-        if (!isValidCollapseCandidate(EdgeID(i)))
+        if (m_edges[i].opposite >= 0)
             continue;
 
-        uint32_t cost = computeCost(EdgeID(i));
+        uint64_t v0 = m_edges[i].vertexIdx;
+        uint64_t v1 = m_edges[next(i)].vertexIdx;
+        borderVertexPairs.push_back((std::min(v0, v1) << 32) | std::max(v0, v1));
+    }
+
+    std::sort(borderVertexPairs.begin(), borderVertexPairs.end());
+
+    m_nonManifoldVertices.resize(m_vertices.size(), 0);
+    for (size_t i = 1; i < borderVertexPairs.size(); ++i)
+    {
+        if (borderVertexPairs[i] != borderVertexPairs[i - 1])
+            continue;
 
-        m_costs[i] = cost;
-        m_sortedEdgeCollapseCandidates.insert(EdgeCollapseCandidate(EdgeID(i), cost));
+        m_nonManifoldVertices[borderVertexPairs[i] >> 32] = 1;
+        m_nonManifoldVertices[borderVertexPairs[i] & 0xFFFFFFFF] = 1;
     }
 }
 
-EdgeID ReducibleDirectedEdgeMesh::reduce()
+template<class TCostPolicy>
+void BasicReducibleDirectedEdgeMesh<TCostPolicy>::initCollapseCandidates()
 {
-    EdgeCollapseCandidate candidate;
+    m_costs.resize(m_edges.size());
+    std::vector<uint8_t> validCandidates(m_edges.size());
 
-    // It's possible that an edge isn't a valid candidate after collapse anymore
-    // -> Get the first valid
-    while (m_sortedEdgeCollapseCandidates.size() > 0)
+    // Scoring and the validity test only read the mesh -> evaluate all edges in parallel
+    ThreadPool::getDefault().parallelFor(m_edges.size(), [this, &validCandidates](size_t i)
     {
-        candidate = *m_sortedEdgeCollapseCandidates.begin();
-        m_sortedEdgeCollapseCandidates.erase(m_sortedEdgeCollapseCandidates.begin());
+        validCandidates[i] = !m_removedFaces[i / 3] && isValidCollapseCandidate(EdgeID(i));
 
-        if (isValidCollapseCandidate(candidate.edgeIdx))
-            break;
+        if (validCandidates[i])
+            m_costs[i] = computeCost(EdgeID(i));
+    });
+
+    std::vector<EdgeCollapseCandidate> candidates;
+    candidates.reserve(m_edges.size());
+
+    for (size_t i = 0; i < m_edges.size(); ++i)
+    {
+        if (validCandidates[i])
+            candidates.push_back(EdgeCollapseCandidate(EdgeID(i), m_costs[i]));
+    }
+
+    // Build the heap in O(n) instead of n insertions
+    if (m_queueMode == CandidateQueueMode::IndexedHeap)
+    {
+        m_sortedEdgeCollapseCandidates.resizeKeys(m_edges.size());
+        m_sortedEdgeCollapseCandidates.assign(std::move(candidates));
+    }
+    else
+    {
+        m_lazyEdgeCollapseCandidates.resizeKeys(m_edges.size());
+        m_lazyEdgeCollapseCandidates.assign(candidates);
     }
+}
+
+template<class TCostPolicy>
+void BasicReducibleDirectedEdgeMesh<TCostPolicy>::initLiveFaces()
+{
+    m_liveFaces.clear();
+    m_liveFaces.reserve(m_removedFaces.size());
+
+    for (size_t i = 0; i < m_removedFaces.size(); ++i)
+    {
+        if (!m_removedFaces[i])
+            m_liveFaces.push_back(FaceIndex(i));
+    }
+}
 
-    if (m_sortedEdgeCollapseCandidates.size() == 0)
+template<class TCostPolicy>
+EdgeID BasicReducibleDirectedEdgeMesh<TCostPolicy>::reduce(float* outError)
+{
+    EdgeCollapseCandidate candidate;
+    if (!selectCollapseCandidate(candidate))
         return -1;
 
-    assert(!m_removedFaces[candidate.edgeIdx / 3]);
+    if (outError)
+        *outError = m_costPolicy.toError(candidate.cost);
 
-    // Get all emanating edges of the neighbors of the vertex on the edge that was deleted
-    // including its own emanating edges
-    auto neighbors = getNeighbors(m_edges[candidate.edgeIdx].vertexIdx);
-    neighbors.push_back(m_edges[candidate.edgeIdx].vertexIdx);
-    std::vector<EdgeID> emanatingEdges;
+    collapseCandidate(candidate.edgeIdx);
+
+    return candidate.edgeIdx;
+}
 
-    for (auto n : neighbors)
+template<class TCostPolicy>
+bool BasicReducibleDirectedEdgeMesh<TCostPolicy>::selectCollapseCandidate(EdgeCollapseCandidate& outCandidate)
+{
+    if (m_queueMode == CandidateQueueMode::MultipleChoice)
+        return selectMultipleChoiceCandidate(outCandidate);
+
+    // It's possible that an edge isn't a valid candidate after collapse anymore
+    // -> Get the first valid
+    bool found = false;
+    while (!found && getCandidateCount() > 0)
+    {
+        outCandidate = popCandidate();
+        found = isValidCollapseCandidate(outCandidate.edgeIdx);
+    }
+
+    if (!found)
+        return false;
+
+    assert(!m_removedFaces[outCandidate.edgeIdx / 3]);
+    return true;
+}
+
+template<class TCostPolicy>
+void BasicReducibleDirectedEdgeMesh<TCostPolicy>::collapseCandidate(EdgeID edgeIdx)
+{
+    // Without a queue neighbors are never reevaluated
+    if (m_queueMode == CandidateQueueMode::MultipleChoice)
     {
-        auto e = getEmanatingEdges(n);
-        emanatingEdges.insert(emanatingEdges.end(), e.begin(), e.end());
+        collapse(edgeIdx);
+        return;
     }
 
-    collapse(candidate.edgeIdx);
+    auto& affectedEdges = m_scratch.affectedEdges;
+    affectedEdges.clear();
+    collectAffectedEdges(edgeIdx, affectedEdges);
+
+    collapse(edgeIdx);
 
     // Reevaluate the edges
-    for (auto e : emanatingEdges)
+    for (auto e : affectedEdges)
     {
         reevaluate(e);
 
         if (m_edges[e].opposite >= 0)
             reevaluate(m_edges[e].opposite);
     }
+}
 
-    return candidate.edgeIdx;
+template<class TCostPolicy>
+bool BasicReducibleDirectedEdgeMesh<TCostPolicy>::selectMultipleChoiceCandidate(EdgeCollapseCandidate& outCandidate)
+{
+    if (!m_sampleValidEdges)
+    {
+        if (sampleLiveFaces(outCandidate))
+            return true;
+
+        // Close to the maximum reduction most of the remaining edges are invalid and random faces rarely hit a valid one
+        // -> from now on the valid edges of a search of all faces are sampled
+        m_sampleValidEdges = true;
+        collectValidEdges();
+    }
+
+    // Every search of all faces is followed by at least one collapse: faces are only searched again
+    // once all collected edges became invalid. This also finds edges that became valid since the last search.
+    if (sampleValidEdges(outCandidate))
+        return true;
+
+    collectValidEdges();
+    if (sampleValidEdges(outCandidate))
+        return true;
+
+    m_foundNoCandidate = true;
+    return false;
+}
+
+template<class TCostPolicy>
+bool BasicReducibleDirectedEdgeMesh<TCostPolicy>::sampleLiveFaces(EdgeCollapseCandidate& outCandidate)
+{
+    EdgeCollapseCandidate::Compare compare;
+    uint32_t validSampleCount = 0;
+    uint32_t maxAttemptCount = MAX_ATTEMPTS_PER_SAMPLE * m_sampleCount;
+
+    for (uint32_t attempt = 0; attempt < maxAttemptCount && validSampleCount < m_sampleCount && !m_liveFaces.empty(); ++attempt)
+    {
+        // mt19937 produces the same sequence on every platform - std distributions don't
+        size_t pos = m_random() % m_liveFaces.size();
+        if (!checkLiveFace(pos))
+            continue;
+
+        EdgeID edgeIdx = EdgeID(m_liveFaces[pos]) * 3 + EdgeID(m_random() % 3);
+        if (!isValidCollapseCandidate(edgeIdx))
+            continue;
+
+        EdgeCollapseCandidate candidate(edgeIdx, computeCost(edgeIdx));
+        if (validSampleCount == 0 || compare(candidate, outCandidate))
+            outCandidate = candidate;
+
+        ++validSampleCount;
+    }
+
+    return validSampleCount > 0;
+}
+
+template<class TCostPolicy>
+bool BasicReducibleDirectedEdgeMesh<TCostPolicy>::sampleValidEdges(EdgeCollapseCandidate& outCandidate)
+{
+    EdgeCollapseCandidate::Compare compare;
+    uint32_t validSampleCount = 0;
+
+    // Every attempt either counts a sample or removes an edge -> at most m_sampleCount + m_validEdges.size() attempts
+    while (validSampleCount < m_sampleCount && !m_validEdges.empty())
+    {
+        size_t pos = m_random() % m_validEdges.size();
+        EdgeID edgeIdx = m_validEdges[pos];
+        if (m_removedFaces[edgeIdx / 3] || !isValidCollapseCandidate(edgeIdx))
+        {
+            m_validEdges[pos] = m_validEdges.back();
+            m_validEdges.pop_back();
+            continue;
+        }
+
+        EdgeCollapseCandidate candidate(edgeIdx, computeCost(edgeIdx));
+        if (validSampleCount == 0 || compare(candidate, outCandidate))
+            outCandidate = candidate;
+
+        ++validSampleCount;
+    }
+
+    return validSampleCount > 0;
 }
 
-void ReducibleDirectedEdgeMesh::reevaluate(EdgeID edgeIdx)
+template<class TCostPolicy>
+void BasicReducibleDirectedEdgeMesh<TCostPolicy>::collectValidEdges()
 {
-    m_sortedEdgeCollapseCandidates.erase(EdgeCollapseCandidate(edgeIdx, m_costs[edgeIdx]));
+    m_validEdges.clear();
+
+    for (size_t pos = m_liveFaces.size(); pos > 0; --pos)
+    {
+        if (!checkLiveFace(pos - 1))
+            continue;
+
+        for (EdgeID edgeIdx = EdgeID(m_liveFaces[pos - 1]) * 3; edgeIdx < EdgeID(m_liveFaces[pos - 1]) * 3 + 3; ++edgeIdx)
+        {
+            if (isValidCollapseCandidate(edgeIdx))
+                m_validEdges.push_back(edgeIdx);
+        }
+    }
+}
+
+template<class TCostPolicy>
+bool BasicReducibleDirectedEdgeMesh<TCostPolicy>::checkLiveFace(size_t pos)
+{
+    if (!m_removedFaces[m_liveFaces[pos]])
+        return true;
+
+    m_liveFaces[pos] = m_liveFaces.back();
+    m_liveFaces.pop_back();
+    return false;
+}
+
+template<class TCostPolicy>
+size_t BasicReducibleDirectedEdgeMesh<TCostPolicy>::reduceRound(const ParallelReductionSettings& settings, std::vector<EdgeID>* outCollapsedEdges)
+{
+    assert(m_queueMode != CandidateQueueMode::MultipleChoice);
+    if (m_queueMode == CandidateQueueMode::MultipleChoice)
+        return 0;
+
+    m_roundEdges.clear();
+    m_serialRoundEdges.clear();
+    m_deferredCandidates.clear();
+
+    if (m_vertexMarks.size() != m_vertices.size())
+        m_vertexMarks.assign(m_vertices.size(), 0);
+
+    if (++m_curVertexMark == 0)
+    {
+        std::fill(m_vertexMarks.begin(), m_vertexMarks.end(), 0);
+        m_curVertexMark = 1;
+    }
+
+    // Select the collapses of this round. Candidates that conflict with an already selected collapse
+    // are added back to the queue. The number of them is limited to keep the selection cheap in flat regions.
+    uint64_t maxCost = 0;
+    size_t maxDeferredCount = 4 * settings.maxBatchSize;
+
+    while (getCandidateCount() > 0 && m_roundEdges.size() + m_serialRoundEdges.size() < settings.maxBatchSize &&
+           m_deferredCandidates.size() < maxDeferredCount)
+    {
+        auto candidate = popCandidate();
+
+        if (!isValidCollapseCandidate(candidate.edgeIdx))
+            continue;
+
+        if (m_roundEdges.empty() && m_serialRoundEdges.empty())
+            maxCost = candidate.cost + uint64_t(candidate.cost * double(settings.costTolerance));
+        else if (candidate.cost > maxCost)
+        {
+            m_deferredCandidates.push_back(candidate);
+            break;
+        }
+
+        if (!tryMarkCollapseNeighborhood(candidate.edgeIdx))
+        {
+            m_deferredCandidates.push_back(candidate);
+            continue;
+        }
+
+        if (requiresSerialCollapse(candidate.edgeIdx))
+            m_serialRoundEdges.push_back(candidate.edgeIdx);
+        else
+            m_roundEdges.push_back(candidate.edgeIdx);
+    }
+
+    // Add them back before the affected edges are rescored - rescoring overrides outdated costs.
+    for (auto& candidate : m_deferredCandidates)
+        updateCandidate(candidate.edgeIdx, candidate.cost);
+
+    size_t collapseCount = m_roundEdges.size() + m_serialRoundEdges.size();
+    if (collapseCount == 0)
+        return 0;
+
+    // The neighborhoods don't overlap -> the collapses write disjoint parts of the mesh.
+    // Records are appended in collapse order, so recording requires a single chunk.
+    auto& threadPool = ThreadPool::getDefault();
+    size_t chunkCount = m_recordCollapses ? 1 : std::max(threadPool.computeChunkCount(m_roundEdges.size(), MIN_COLLAPSES_PER_CHUNK), size_t(1));
+    if (m_roundScratch.size() < chunkCount)
+        m_roundScratch.resize(chunkCount);
+
+    std::vector<size_t> removedFaceCounts(chunkCount, 0);
+    threadPool.run(chunkCount, [this, chunkCount, &removedFaceCounts](size_t chunkIdx)
+    {
+        auto& scratch = m_roundScratch[chunkIdx];
+        scratch.affectedEdges.clear();
+
+        size_t begin = chunkIdx * m_roundEdges.size() / chunkCount;
+        size_t end = (chunkIdx + 1) * m_roundEdges.size() / chunkCount;
+        size_t removedFaceCount = 0;
+
+        for (size_t i = begin; i < end; ++i)
+        {
+            collectAffectedEdges(m_roundEdges[i], scratch.affectedEdges);
+            removedFaceCount += collapse(m_roundEdges[i], scratch);
+        }
+
+        removedFaceCounts[chunkIdx] = removedFaceCount;
+    });
+
+    for (auto count : removedFaceCounts)
+        m_removedFaceCount += count;
+
+    auto& affectedEdges = m_scratch.affectedEdges;
+    affectedEdges.clear();
+
+    for (auto e : m_serialRoundEdges)
+    {
+        collectAffectedEdges(e, affectedEdges);
+        m_removedFaceCount += collapse(e, m_scratch);
+    }
+
+    for (size_t i = 0; i < chunkCount; ++i)
+        affectedEdges.insert(affectedEdges.end(), m_roundScratch[i].affectedEdges.begin(), m_roundScratch[i].affectedEdges.end());
+
+    size_t affectedEdgeCount = affectedEdges.size();
+    for (size_t i = 0; i < affectedEdgeCount; ++i)
+    {
+        if (m_edges[affectedEdges[i]].opposite >= 0)
+            affectedEdges.push_back(m_edges[affectedEdges[i]].opposite);
+    }
+
+    // Rescore in parallel, the queue is updated serially. Edges can be affected by multiple collapses
+    // -> the results are stored per entry to avoid concurrent writes to m_costs.
+    m_affectedEdgeValid.resize(affectedEdges.size());
+    m_affectedEdgeCosts.resize(affectedEdges.size());
+
+    threadPool.parallelFor(affectedEdges.size(), [this, &affectedEdges](size_t i)
+    {
+        EdgeID e = affectedEdges[i];
+        m_affectedEdgeValid[i] = !m_removedFaces[e / 3] && isValidCollapseCandidate(e);
+
+        if (m_affectedEdgeValid[i])
+            m_affectedEdgeCosts[i] = computeCost(e);
+    });
+
+    for (size_t i = 0; i < affectedEdges.size(); ++i)
+    {
+        if (m_affectedEdgeValid[i])
+            updateCandidate(affectedEdges[i], m_affectedEdgeCosts[i]);
+        else
+            removeCandidate(affectedEdges[i]);
+    }
+
+    if (outCollapsedEdges)
+    {
+        outCollapsedEdges->insert(outCollapsedEdges->end(), m_roundEdges.begin(), m_roundEdges.end());
+        outCollapsedEdges->insert(outCollapsedEdges->end(), m_serialRoundEdges.begin(), m_serialRoundEdges.end());
+    }
+
+    return collapseCount;
+}
+
+template<class TCostPolicy>
+size_t BasicReducibleDirectedEdgeMesh<TCostPolicy>::reduceParallel(size_t targetFaceCount, const ParallelReductionSettings& settings,
+                                                                   std::vector<EdgeID>* outCollapsedEdges)
+{
+    size_t collapseCount = 0;
+    ParallelReductionSettings roundSettings = settings;
+
+    while (getFaceCount() > targetFaceCount)
+    {
+        // A collapse removes up to 2 faces -> limit the batch to avoid overshooting the target
+        roundSettings.maxBatchSize = std::max(std::min(settings.maxBatchSize, (getFaceCount() - targetFaceCount + 1) / 2), size_t(1));
+
+        size_t roundCollapseCount = reduceRound(roundSettings, outCollapsedEdges);
+        if (roundCollapseCount == 0)
+            break;
+
+        collapseCount += roundCollapseCount;
+    }
+
+    return collapseCount;
+}
+
+template<class TCostPolicy>
+size_t BasicReducibleDirectedEdgeMesh<TCostPolicy>::reduceToError(const ErrorBoundedReductionSettings& settings, std::vector<EdgeID>* outCollapsedEdges,
+                                                                  std::vector<float>* outCollapseErrors, float* outAccumulatedError)
+{
+    size_t collapseCount = 0;
+    float accumulatedError = 0.0f;
+    EdgeCollapseCandidate candidate;
+
+    while (selectCollapseCandidate(candidate))
+    {
+        float error = m_costPolicy.toError(candidate.cost);
+
+        if (error > settings.maxCollapseError || accumulatedError + error > settings.maxAccumulatedError)
+        {
+            // The candidate isn't collapsed -> return it to the queue
+            if (m_queueMode != CandidateQueueMode::MultipleChoice)
+                updateCandidate(candidate.edgeIdx, candidate.cost);
+
+            break;
+        }
+
+        collapseCandidate(candidate.edgeIdx);
+        accumulatedError += error;
+        ++collapseCount;
+
+        if (outCollapsedEdges)
+            outCollapsedEdges->push_back(candidate.edgeIdx);
+
+        if (outCollapseErrors)
+            outCollapseErrors->push_back(error);
+    }
+
+    if (outAccumulatedError)
+        *outAccumulatedError = accumulatedError;
+
+    return collapseCount;
+}
+
+template<class TCostPolicy>
+void BasicReducibleDirectedEdgeMesh<TCostPolicy>::collectAffectedEdges(EdgeID edgeIdx, std::vector<EdgeID>& outEdges) const
+{
+    // Get all emanating edges of the neighbors of the vertex on the edge that is deleted
+    // including its own emanating edges
+    auto vIdx = m_edges[edgeIdx].vertexIdx;
+
+    auto addEmanatingEdges = [this, &outEdges](VertexIndex v)
+    {
+        forEachEmanatingEdge(v, [&outEdges](EdgeID e) { outEdges.push_back(e); });
+    };
+
+    forEachNeighbor(vIdx, addEmanatingEdges);
+    addEmanatingEdges(vIdx);
+}
+
+template<class TCostPolicy>
+bool BasicReducibleDirectedEdgeMesh<TCostPolicy>::tryMarkCollapseNeighborhood(EdgeID edgeIdx)
+{
+    // A collapse only touches faces adjacent to the closed 1-ring of the deleted vertex. Two collapses
+    // are independent if no vertex of one closed 1-ring is in or adjacent to the other closed 1-ring.
+    auto vIdx = m_edges[edgeIdx].vertexIdx;
+    bool conflict = m_vertexMarks[vIdx] == m_curVertexMark;
+    forEachNeighbor(vIdx, [this, &conflict](VertexIndex n) { conflict = conflict || m_vertexMarks[n] == m_curVertexMark; });
+
+    if (conflict)
+        return false;
+
+    auto mark = [this](VertexIndex v) { m_vertexMarks[v] = m_curVertexMark; };
+
+    mark(vIdx);
+    forEachNeighbor(vIdx, [this, &mark](VertexIndex n)
+    {
+        mark(n);
+        forEachNeighbor(n, mark);
+    });
 
+    return true;
+}
+
+template<class TCostPolicy>
+bool BasicReducibleDirectedEdgeMesh<TCostPolicy>::requiresSerialCollapse(EdgeID ei) const
+{
+    auto vi = m_edges[ei].vertexIdx;
+    auto vj = m_edges[next(ei)].vertexIdx;
+
+    if (!isBorderVertex(vj))
+        return isBorderVertex(vi);
+
+    // The emanating edges of i are added to the list of j which must not be moved
+    auto& list = getBorderEdgeList(vj);
+    return list.count + m_valences[vi] > list.capacity;
+}
+
+template<class TCostPolicy>
+void BasicReducibleDirectedEdgeMesh<TCostPolicy>::reevaluate(EdgeID edgeIdx)
+{
     if (m_removedFaces[edgeIdx / 3] || !isValidCollapseCandidate(edgeIdx))
+    {
+        removeCandidate(edgeIdx);
         return;
+    }
+
+    updateCandidate(edgeIdx, computeCost(edgeIdx));
+}
 
-    uint32_t cost = computeCost(edgeIdx);
+template<class TCostPolicy>
+void BasicReducibleDirectedEdgeMesh<TCostPolicy>::updateCandidate(EdgeID edgeIdx, uint32_t cost)
+{
     m_costs[edgeIdx] = cost;
-    m_sortedEdgeCollapseCandidates.insert(EdgeCollapseCandidate(edgeIdx, cost));
+
+    // Indexed heap: updates the candidate in place or adds it if it isn't in the heap
+    // Lazy heap: pushes a new entry and invalidates the old one
+    if (m_queueMode == CandidateQueueMode::IndexedHeap)
+        m_sortedEdgeCollapseCandidates.update(EdgeCollapseCandidate(edgeIdx, cost));
+    else
+        m_lazyEdgeCollapseCandidates.update(EdgeCollapseCandidate(edgeIdx, cost));
+}
+
+template<class TCostPolicy>
+void BasicReducibleDirectedEdgeMesh<TCostPolicy>::removeCandidate(EdgeID edgeIdx)
+{
+    if (m_queueMode == CandidateQueueMode::IndexedHeap)
+        m_sortedEdgeCollapseCandidates.remove(edgeIdx);
+    else
+        m_lazyEdgeCollapseCandidates.remove(edgeIdx);
+}
+
+template<class TCostPolicy>
+EdgeCollapseCandidate BasicReducibleDirectedEdgeMesh<TCostPolicy>::popCandidate()
+{
+    if (m_queueMode == CandidateQueueMode::IndexedHeap)
+        return m_sortedEdgeCollapseCandidates.pop();
+
+    return m_lazyEdgeCollapseCandidates.pop();
+}
+
+template<class TCostPolicy>
+size_t BasicReducibleDirectedEdgeMesh<TCostPolicy>::getCandidateCount() const
+{
+    // Without a queue only an upper bound is known
+    if (m_queueMode == CandidateQueueMode::MultipleChoice)
+        return m_foundNoCandidate ? 0 : 3 * m_liveFaces.size();
+
+    if (m_queueMode == CandidateQueueMode::None)
+        return 0;
+
+    if (m_queueMode == CandidateQueueMode::IndexedHeap)
+        return m_sortedEdgeCollapseCandidates.size();
+
+    return m_lazyEdgeCollapseCandidates.size();
 }
 
-bool ReducibleDirectedEdgeMesh::isValidCollapseCandidate(EdgeID edgeIdx)
+template<class TCostPolicy>
+bool BasicReducibleDirectedEdgeMesh<TCostPolicy>::isValidCollapseCandidate(EdgeID edgeIdx) const
 {
     assert(edgeIdx >= 0 && edgeIdx < EdgeID(m_edges.size()) && !m_removedFaces[edgeIdx / 3]);
 
@@ -100,6 +645,9 @@ bool ReducibleDirectedEdgeMesh::isValidCollapseCandidate(EdgeID edgeIdx)
 
     EdgeID opposite = m_edges[edgeIdx].opposite;
 
+    if (!m_nonManifoldVertices.empty() && (m_nonManifoldVertices[ei.vertexIdx] || m_nonManifoldVertices[ej.vertexIdx]))
+        return false;
+
     // If Pi and Pj are both boundary points then edge (Pi, Pj) must be a boundary edge
     if (pi.id < 0 && pj.id < 0)
     {
@@ -107,35 +655,74 @@ bool ReducibleDirectedEdgeMesh::isValidCollapseCandidate(EdgeID edgeIdx)
             return false;
     }
 
-    std::vector<VertexIndex> adj;
-    adj.push_back(m_edges[next(ejID)].vertexIdx);
+    VertexIndex adj[2];
+    uint32_t adjCount = 0;
+    adj[adjCount++] = m_edges[next(ejID)].vertexIdx;
 
     if (opposite >= 0)
-        adj.push_back(m_edges[prev(opposite)].vertexIdx);
+    {
+        adj[adjCount++] = m_edges[prev(opposite)].vertexIdx;
 
-    std::sort(adj.begin(), adj.end());
+        // Both faces share all vertices
+        if (adj[0] == adj[1])
+            return false;
+    }
+
+    // The valence of the points Pk mentioned below must be greater than 3.
+    // This is an O(1) lookup, so reject these candidates before the one-rings are walked.
+    for (uint32_t i = 0; i < adjCount; ++i)
+        if (m_valences[adj[i]] <= 3)
+            return false;
 
     // For all points Pk adjacent to the points of the edge (Pi, Pj) a triangle (Pk, Pi, Pj) must exist
     // or in other words: the intersection between the sets of adjacent vertices of Pi and Pj
     // must be the set of the vertices opposite to the collapsed edge.
-    auto adjPi = getNeighbors(ei.vertexIdx);
-    auto adjPj = getNeighbors(ej.vertexIdx);
-    auto adjOfBoth = setOp::sort::intersection(adjPi, adjPj);
-
-    assert(adjOfBoth.size() != 0);
+    // The opposite vertices are always adjacent to both points -> it's enough to count the common neighbors.
+    uint32_t commonCount = 0;
+    VertexIndex neighborsOfPj[MAX_CACHED_VALENCE];
+    uint32_t neighborCount = 0;
+    bool cached = m_valences[ej.vertexIdx] <= MAX_CACHED_VALENCE;
+
+    // Walk the one-ring of Pj only once. The valence is a hint only, the cache must not overflow if it's off.
+    if (cached)
+    {
+        forEachNeighbor(ej.vertexIdx, [&neighborsOfPj, &neighborCount, &cached](VertexIndex m)
+        {
+            if (neighborCount < MAX_CACHED_VALENCE)
+                neighborsOfPj[neighborCount++] = m;
+            else
+                cached = false;
+        });
+    }
 
-    if (!setOp::sorted::equal(adjOfBoth, adj))
-        return false;
+    if (cached)
+    {
+        forEachNeighbor(ei.vertexIdx, [&neighborsOfPj, neighborCount, &commonCount](VertexIndex n)
+        {
+            for (uint32_t i = 0; i < neighborCount; ++i)
+                if (n == neighborsOfPj[i])
+                    ++commonCount;
+        });
+    }
+    else
+    {
+        forEachNeighbor(ei.vertexIdx, [this, &ej, &commonCount](VertexIndex n)
+        {
+            forEachNeighbor(ej.vertexIdx, [n, &commonCount](VertexIndex m)
+            {
+                if (n == m)
+                    ++commonCount;
+            });
+        });
+    }
 
-    // The valence of the points Pk mentioned above must be greater than 3.
-    for (size_t i = 0; i < adjOfBoth.size(); ++i)
-        if (valenceOf(adjOfBoth[i]) <= 3)
-            return false;
+    assert(commonCount != 0);
 
-    return true;
+    return commonCount == adjCount;
 }
 
-void ReducibleDirectedEdgeMesh::adjustOpposites(EdgeID edgeIdx)
+template<class TCostPolicy>
+void BasicReducibleDirectedEdgeMesh<TCostPolicy>::adjustOpposites(EdgeID edgeIdx)
 {
     auto oppositeOfNext = m_edges[next(edgeIdx)].opposite;
     auto oppositeOfPrev = m_edges[prev(edgeIdx)].opposite;
@@ -147,33 +734,42 @@ void ReducibleDirectedEdgeMesh::adjustOpposites(EdgeID edgeIdx)
         m_edges[oppositeOfPrev].opposite = oppositeOfNext;
 }
 
-void ReducibleDirectedEdgeMesh::deleteEmanatingEdges(VertexIndex vIdx)
+template<class TCostPolicy>
+void BasicReducibleDirectedEdgeMesh<TCostPolicy>::restoreOpposites(EdgeID edgeIdx)
 {
-    auto vID = m_vertices[vIdx].id;
-    if (vID < 0)
-    {
-        auto& e = m_emanatingEdges[-vID - 1];
-        std::vector<size_t> erasePositions;
-        for (int i = e.size() - 1; i >= 0; --i)
-        {
-            if (m_removedFaces[e[i] / 3])
-                erasePositions.push_back(i);
-        }
+    auto oppositeOfNext = m_edges[next(edgeIdx)].opposite;
+    auto oppositeOfPrev = m_edges[prev(edgeIdx)].opposite;
 
-        assert(erasePositions.size() > 0);
-        for (auto pos : erasePositions)
-            e.erase(e.begin() + pos);
+    if (oppositeOfNext >= 0)
+        m_edges[oppositeOfNext].opposite = next(edgeIdx);
+
+    if (oppositeOfPrev >= 0)
+        m_edges[oppositeOfPrev].opposite = prev(edgeIdx);
+}
+
+template<class TCostPolicy>
+void BasicReducibleDirectedEdgeMesh<TCostPolicy>::deleteEmanatingEdges(VertexIndex vIdx)
+{
+    if (isBorderVertex(vIdx))
+    {
+        uint32_t removedCount = removeBorderEmanatingEdges(vIdx, [this](EdgeID i) { return m_removedFaces[i / 3] != 0; });
+        assert(removedCount > 0);
+        (void)removedCount;
     }
 }
 
-void ReducibleDirectedEdgeMesh::adjustEmanatingEdgeIndex(VertexIndex vIdx)
+template<class TCostPolicy>
+void BasicReducibleDirectedEdgeMesh<TCostPolicy>::adjustEmanatingEdgeIndex(VertexIndex vIdx)
 {
-    auto vID = m_vertices[vIdx].id;
-    if (vID < 0)
+    if (isBorderVertex(vIdx))
     {
-        m_vertices[vIdx].edgeID = m_emanatingEdges[-vID - 1][0];
+        // The list of the remaining vertex is empty if all of its faces were removed.
+        // It receives the emanating edges of the deleted vertex at the end of collapse().
+        if (getBorderEdgeList(vIdx).count > 0)
+            m_vertices[vIdx].edgeID = m_borderEmanatingEdges[getBorderEdgeList(vIdx).offset];
+
         return;
-    }    
+    }
 
     EdgeID startIdx = m_vertices[vIdx].edgeID;
     EdgeID curIndex = startIdx;
@@ -194,88 +790,84 @@ void ReducibleDirectedEdgeMesh::adjustEmanatingEdgeIndex(VertexIndex vIdx)
     assert(false);
 }
 
-uint32_t ReducibleDirectedEdgeMesh::computeCost(EdgeID edgeIdx)
+template<class TCostPolicy>
+void BasicReducibleDirectedEdgeMesh<TCostPolicy>::collapse(EdgeID ei)
 {
-    auto vi0 = m_edges[edgeIdx].vertexIdx;
-    auto vi1 = m_edges[next(edgeIdx)].vertexIdx;
-
-    auto v0 = m_subMesh.vertices[vi0];
-    auto v1 = m_subMesh.vertices[vi1];
-
-    float edgeLength = glm::length(v0 - v1);
-    float curvature = 0.0f;
-
-    auto adjFacesStart = getAdjacentFaces(vi0);
-    auto adjFacesNext = getAdjacentFaces(vi1);
-    auto adjFacesEdge = setOp::intersection(adjFacesStart, adjFacesNext);
-
-    for (size_t i = 0; i < adjFacesStart.size(); ++i)
-    {
-        float minCurvature = 1.0f;
-
-        for (size_t j = 0; j < adjFacesEdge.size(); ++j)
-        {
-            auto n0 = computeFaceNormal(adjFacesStart[i]);
-            auto n1 = computeFaceNormal(adjFacesEdge[j]);
-            auto d = glm::dot(n0, n1);
-            minCurvature = std::min(minCurvature, (1.0f - d) / 2.0f);
-        }
-
-        curvature = std::max(curvature, minCurvature);
-    }
-
-    // Convert float to an integer type to avoid floating point imprecision errors which fail the equality test on specific architectures.
-    return uint32_t(edgeLength * curvature * 10e7f);
+    m_removedFaceCount += collapse(ei, m_scratch);
 }
 
 // Note: The vertex associated with ei is deleted.
-void ReducibleDirectedEdgeMesh::collapse(EdgeID ei)
+template<class TCostPolicy>
+uint32_t BasicReducibleDirectedEdgeMesh<TCostPolicy>::collapse(EdgeID ei, RingScratchArena& scratch)
 {
     assert(isValidCollapseCandidate(ei));
 
     EdgeID ej = next(ei);
     EdgeID opposite = m_edges[ei].opposite;
 
+    // The one-rings are modified during the collapse -> materialize them first
     auto vIdx = m_edges[ei].vertexIdx;
-    auto emanatingEdges = getEmanatingEdges(vIdx);
-    auto emanatingEdgesOfNext = getEmanatingEdges(m_edges[ej].vertexIdx);
+    bool border = m_vertices[vIdx].id < 0;
+    auto& emanatingEdges = scratch.edges;
+    auto& emanatingEdgesOfNext = scratch.edgesOfNext;
+    getEmanatingEdges(vIdx, emanatingEdges);
+
+    if (m_recordCollapses)
+        recordCollapse(ei, emanatingEdges);
+
+    // Only needed if j turns into a border vertex
+    if (border && m_vertices[m_edges[ej].vertexIdx].id >= 0)
+        getEmanatingEdges(m_edges[ej].vertexIdx, emanatingEdgesOfNext);
 
     // Save the vertices opposite to the edge
-    std::vector<VertexIndex> oppositeVertices;
-    oppositeVertices.push_back(m_edges[next(ej)].vertexIdx);
+    VertexIndex oppositeVertices[2];
+    uint32_t oppositeVertexCount = 0;
+    oppositeVertices[oppositeVertexCount++] = m_edges[next(ej)].vertexIdx;
 
     if (opposite >= 0)
-        oppositeVertices.push_back(m_edges[prev(opposite)].vertexIdx);
+        oppositeVertices[oppositeVertexCount++] = m_edges[prev(opposite)].vertexIdx;
+
+    // j is connected to the neighbors of i except for j itself and the opposite vertices
+    // which are already neighbors of j. The opposite vertices lose i.
+    auto vjIdx = m_edges[ej].vertexIdx;
+    m_valences[vjIdx] += m_valences[vIdx] - 2 - oppositeVertexCount;
+    for (uint32_t i = 0; i < oppositeVertexCount; ++i)
+        --m_valences[oppositeVertices[i]];
+
+    auto costUndoData = m_costPolicy.onCollapse(*this, ei);
+    if (m_recordCollapses)
+        m_collapseRecords.back().costUndoData = costUndoData;
 
     // Mark the faces as removed
+    uint32_t removedFaceCount = 1;
     m_removedFaces[ei / 3] = true;
-    ++m_removedFaceCount;
     if (opposite >= 0)
     {
         assert(m_edges[opposite].vertexIdx == m_edges[ej].vertexIdx);
         m_removedFaces[opposite / 3] = true;
-        ++m_removedFaceCount;
+        ++removedFaceCount;
     }
 
     // Delete the emanating edges which belong to the removed faces of border vertices 
     deleteEmanatingEdges(m_edges[ej].vertexIdx);
-    for (auto i : oppositeVertices)
-        deleteEmanatingEdges(i);
+    for (uint32_t i = 0; i < oppositeVertexCount; ++i)
+        deleteEmanatingEdges(oppositeVertices[i]);
 
     adjustEmanatingEdgeIndex(m_edges[ej].vertexIdx);
-    for (size_t i = 0; i < oppositeVertices.size(); ++i)
+    for (uint32_t i = 0; i < oppositeVertexCount; ++i)
         adjustEmanatingEdgeIndex(oppositeVertices[i]);
 
     auto vID = m_vertices[m_edges[ej].vertexIdx].id;
 
-    // Let neighbors of the deleted vertex point to its next vertex
-    bool border = m_vertices[m_edges[ei].vertexIdx].id < 0;
+    // Let neighbors of the deleted vertex point to its next vertex.
+    // Only these faces change their shape -> update their normals.
     for (auto i : emanatingEdges)
     {
         if (m_removedFaces[i / 3])
             continue;
 
         m_edges[i].vertexIdx = m_edges[ej].vertexIdx;
+        m_faceNormals[i / 3] = computeFaceNormal(i / 3);
     }
 
     adjustOpposites(ei);
@@ -286,9 +878,8 @@ void ReducibleDirectedEdgeMesh::collapse(EdgeID ei)
     // Check if j turned into a border vertex
     if (border && vID >= 0)
     {
-        vID = -VertexID(m_emanatingEdges.size()) - 1;
-        m_vertices[m_edges[ej].vertexIdx].id = vID;
-        m_emanatingEdges.push_back(emanatingEdgesOfNext);
+        addBorderVertex(m_edges[ej].vertexIdx, emanatingEdgesOfNext);
+        vID = m_vertices[m_edges[ej].vertexIdx].id;
         deleteEmanatingEdges(m_edges[ej].vertexIdx);
     }
 
@@ -300,16 +891,304 @@ void ReducibleDirectedEdgeMesh::collapse(EdgeID ei)
             if (m_removedFaces[i / 3])
                 continue;
 
-            m_emanatingEdges[-vID - 1].push_back(i);
+            addBorderEmanatingEdge(m_edges[ej].vertexIdx, i);
+        }
+    }
+
+    return removedFaceCount;
+}
+
+template<class TCostPolicy>
+uint32_t BasicReducibleDirectedEdgeMesh<TCostPolicy>::getCollapseVertices(EdgeID ei, VertexIndex outVertices[3]) const
+{
+    EdgeID opposite = m_edges[ei].opposite;
+    uint32_t vertexCount = 0;
+    outVertices[vertexCount++] = m_edges[next(ei)].vertexIdx;
+    outVertices[vertexCount++] = m_edges[prev(ei)].vertexIdx;
+
+    if (opposite >= 0)
+        outVertices[vertexCount++] = m_edges[prev(opposite)].vertexIdx;
+
+    return vertexCount;
+}
+
+template<class TCostPolicy>
+void BasicReducibleDirectedEdgeMesh<TCostPolicy>::recordCollapse(EdgeID ei, const std::vector<EdgeID>& emanatingEdges)
+{
+    EdgeID opposite = m_edges[ei].opposite;
+
+    CollapseRecord record;
+    record.edgeIdx = ei;
+    record.edgeOffset = uint32_t(m_collapseRecordEdges.size());
+    record.borderListCount = uint32_t(m_borderEdgeLists.size());
+    record.borderEdgeCount = uint32_t(m_borderEmanatingEdges.size());
+
+    // The edges of the deleted vertex that remain after the collapse
+    for (auto e : emanatingEdges)
+    {
+        if (e / 3 == ei / 3 || (opposite >= 0 && e / 3 == opposite / 3))
+            continue;
+
+        m_collapseRecordEdges.push_back(e);
+        ++record.movedEdgeCount;
+    }
+
+    VertexIndex vertices[3];
+    uint32_t vertexCount = getCollapseVertices(ei, vertices);
+
+    for (uint32_t i = 0; i < vertexCount; ++i)
+    {
+        record.vertices[i] = m_vertices[vertices[i]];
+
+        if (!isBorderVertex(vertices[i]))
+            continue;
+
+        auto& list = getBorderEdgeList(vertices[i]);
+        record.borderLists[i] = list;
+        m_collapseRecordEdges.insert(m_collapseRecordEdges.end(), m_borderEmanatingEdges.begin() + list.offset,
+                                     m_borderEmanatingEdges.begin() + list.offset + list.count);
+    }
+
+    m_collapseRecords.push_back(record);
+}
+
+template<class TCostPolicy>
+void BasicReducibleDirectedEdgeMesh<TCostPolicy>::setCollapseRecording(bool enabled)
+{
+    m_recordCollapses = enabled;
+
+    if (!enabled)
+    {
+        m_collapseRecords.clear();
+        m_collapseRecordEdges.clear();
+    }
+}
+
+// Note: The steps of collapse() are undone in reverse order.
+template<class TCostPolicy>
+EdgeID BasicReducibleDirectedEdgeMesh<TCostPolicy>::split()
+{
+    if (m_collapseRecords.empty())
+        return -1;
+
+    const CollapseRecord& record = m_collapseRecords.back();
+    EdgeID ei = record.edgeIdx;
+    EdgeID opposite = m_edges[ei].opposite;
+    auto vIdx = m_edges[ei].vertexIdx;
+
+    VertexIndex vertices[3];
+    uint32_t vertexCount = getCollapseVertices(ei, vertices);
+
+    // Lists that were added or moved by the collapse are at the end. The old ranges of moved lists are never reused,
+    // so the old content can be written back.
+    m_borderEdgeLists.resize(record.borderListCount);
+    m_borderEmanatingEdges.resize(record.borderEdgeCount);
+    const EdgeID* savedListEdges = m_collapseRecordEdges.data() + record.edgeOffset + record.movedEdgeCount;
+
+    for (uint32_t i = 0; i < vertexCount; ++i)
+    {
+        m_vertices[vertices[i]] = record.vertices[i];
+
+        if (record.vertices[i].id >= 0)
+            continue;
+
+        auto& list = m_borderEdgeLists[-record.vertices[i].id - 1];
+        list = record.borderLists[i];
+        std::copy(savedListEdges, savedListEdges + list.count, m_borderEmanatingEdges.begin() + list.offset);
+        savedListEdges += list.count;
+    }
+
+    if (opposite >= 0)
+        restoreOpposites(opposite);
+
+    restoreOpposites(ei);
+
+    const EdgeID* movedEdges = m_collapseRecordEdges.data() + record.edgeOffset;
+    for (uint32_t i = 0; i < record.movedEdgeCount; ++i)
+    {
+        m_edges[movedEdges[i]].vertexIdx = vIdx;
+        m_faceNormals[movedEdges[i] / 3] = computeFaceNormal(movedEdges[i] / 3);
+    }
+
+    m_removedFaces[ei / 3] = false;
+    --m_removedFaceCount;
+    if (opposite >= 0)
+    {
+        m_removedFaces[opposite / 3] = false;
+        --m_removedFaceCount;
+    }
+
+    m_costPolicy.onSplit(*this, ei, record.costUndoData);
+
+    // vertices[0] is the remaining vertex, the others are the opposite vertices
+    m_valences[vertices[0]] -= m_valences[vIdx] - 2 - (vertexCount - 1);
+    for (uint32_t i = 1; i < vertexCount; ++i)
+        ++m_valences[vertices[i]];
+
+    m_collapseRecordEdges.resize(record.edgeOffset);
+    m_collapseRecords.pop_back();
+
+    return ei;
+}
+
+template<class TCostPolicy>
+void BasicReducibleDirectedEdgeMesh<TCostPolicy>::resetCollapseCandidates()
+{
+    if (m_queueMode == CandidateQueueMode::MultipleChoice)
+    {
+        initLiveFaces();
+        m_validEdges.clear();
+        m_sampleValidEdges = false;
+        m_foundNoCandidate = false;
+    }
+    else if (m_queueMode != CandidateQueueMode::None)
+        initCollapseCandidates();
+}
+
+template<class TCostPolicy>
+size_t BasicReducibleDirectedEdgeMesh<TCostPolicy>::reduceToLods(const std::vector<float>& thresholds, LodThresholdType thresholdType,
+                                                                 std::vector<Mesh::SubMesh>& outLods, std::vector<EdgeID>* outCollapsedEdges)
+{
+    outLods.clear();
+    outLods.resize(thresholds.size());
+
+    // Levels are taken from the finest to the coarsest
+    std::vector<size_t> lodOrder(thresholds.size());
+    for (size_t i = 0; i < lodOrder.size(); ++i)
+        lodOrder[i] = i;
+
+    std::stable_sort(lodOrder.begin(), lodOrder.end(), [&thresholds, thresholdType](size_t lhs, size_t rhs)
+    {
+        if (thresholdType == LodThresholdType::FaceRatio)
+            return thresholds[lhs] > thresholds[rhs];
+
+        return thresholds[lhs] < thresholds[rhs];
+    });
+
+    // Compacted lists of the remaining faces and vertices with the position of every element in its list.
+    // Removed elements are swapped with the last element.
+    std::vector<FaceIndex> liveFaces;
+    std::vector<uint32_t> facePositions(m_removedFaces.size(), 0);
+    std::vector<VertexIndex> liveVertices;
+    std::vector<uint32_t> vertexPositions(m_vertices.size(), 0);
+    std::vector<uint8_t> referencedVertices(m_vertices.size(), 0);
+
+    for (size_t f = 0; f < m_removedFaces.size(); ++f)
+    {
+        if (m_removedFaces[f])
+            continue;
+
+        facePositions[f] = uint32_t(liveFaces.size());
+        liveFaces.push_back(FaceIndex(f));
+
+        for (size_t r = 0; r < 3; ++r)
+            referencedVertices[m_edges[3 * f + r].vertexIdx] = 1;
+    }
+
+    for (size_t v = 0; v < m_vertices.size(); ++v)
+    {
+        if (!referencedVertices[v])
+            continue;
+
+        vertexPositions[v] = uint32_t(liveVertices.size());
+        liveVertices.push_back(VertexIndex(v));
+    }
+
+    auto removeFace = [&liveFaces, &facePositions](FaceIndex faceIdx)
+    {
+        FaceIndex last = liveFaces.back();
+        liveFaces[facePositions[faceIdx]] = last;
+        facePositions[last] = facePositions[faceIdx];
+        liveFaces.pop_back();
+    };
+
+    auto removeVertex = [&liveVertices, &vertexPositions](VertexIndex vIdx)
+    {
+        VertexIndex last = liveVertices.back();
+        liveVertices[vertexPositions[vIdx]] = last;
+        vertexPositions[last] = vertexPositions[vIdx];
+        liveVertices.pop_back();
+    };
+
+    auto takeSnapshot = [&](Mesh::SubMesh& lod)
+    {
+        lod.vertices.resize(liveVertices.size());
+        lod.normals.resize(liveVertices.size());
+        for (size_t i = 0; i < liveVertices.size(); ++i)
+        {
+            lod.vertices[i] = m_geometry.positions[liveVertices[i]];
+            lod.normals[i] = computeCachedVertexNormal(liveVertices[i]);
         }
+
+        lod.indices.resize(3 * liveFaces.size());
+        for (size_t i = 0; i < liveFaces.size(); ++i)
+        {
+            for (size_t r = 0; r < 3; ++r)
+                lod.indices[3 * i + r] = IndexType(vertexPositions[m_edges[3 * liveFaces[i] + r].vertexIdx]);
+        }
+    };
+
+    size_t initialFaceCount = getFaceCount();
+    size_t nextLod = 0;
+    size_t collapseCount = 0;
+    EdgeCollapseCandidate candidate;
+    bool hasCandidate = false;
+
+    while (nextLod < lodOrder.size())
+    {
+        float threshold = thresholds[lodOrder[nextLod]];
+
+        if (thresholdType == LodThresholdType::FaceRatio && double(getFaceCount()) <= double(threshold) * double(initialFaceCount))
+        {
+            takeSnapshot(outLods[lodOrder[nextLod++]]);
+            continue;
+        }
+
+        if (!hasCandidate && !selectCollapseCandidate(candidate))
+            break;
+
+        // The error of the next collapse is only known after it is selected -> it is kept for the next level
+        hasCandidate = true;
+        if (thresholdType == LodThresholdType::Error && m_costPolicy.toError(candidate.cost) > threshold)
+        {
+            takeSnapshot(outLods[lodOrder[nextLod++]]);
+            continue;
+        }
+
+        // The halfedges of the removed faces aren't modified by the collapse
+        EdgeID opposite = m_edges[candidate.edgeIdx].opposite;
+        collapseCandidate(candidate.edgeIdx);
+        hasCandidate = false;
+
+        removeFace(FaceIndex(candidate.edgeIdx / 3));
+        if (opposite >= 0)
+            removeFace(FaceIndex(opposite / 3));
+
+        removeVertex(m_edges[candidate.edgeIdx].vertexIdx);
+
+        if (outCollapsedEdges)
+            outCollapsedEdges->push_back(candidate.edgeIdx);
+
+        ++collapseCount;
     }
+
+    // Levels that can't be reached
+    for (; nextLod < lodOrder.size(); ++nextLod)
+        takeSnapshot(outLods[lodOrder[nextLod]]);
+
+    // The selected but not collapsed candidate is returned to the queue
+    if (hasCandidate && m_queueMode != CandidateQueueMode::MultipleChoice)
+        updateCandidate(candidate.edgeIdx, candidate.cost);
+
+    return collapseCount;
 }
 
-Mesh::SubMesh ReducibleDirectedEdgeMesh::getReducedSubMesh()
+template<class TCostPolicy>
+Mesh::SubMesh BasicReducibleDirectedEdgeMesh<TCostPolicy>::getReducedSubMesh()
 {
     Mesh::SubMesh reducedMesh;
     std::vector<VertexID> vertexIDs;
-    vertexIDs.resize(m_subMesh.vertices.size());
+    vertexIDs.resize(m_geometry.vertexCount);
     std::fill(vertexIDs.begin(), vertexIDs.end(), -1);
 
     for (size_t i = 0; i < m_edges.size(); ++i)
@@ -322,8 +1201,8 @@ Mesh::SubMesh ReducibleDirectedEdgeMesh::getReducedSubMesh()
             if (vertexIDs[vIdx] < 0)
             {
                 vertexIDs[vIdx] = reducedMesh.vertices.size();
-                reducedMesh.vertices.push_back(m_subMesh.vertices[vIdx]);
-                reducedMesh.normals.push_back(computeVertexNormal(vIdx));
+                reducedMesh.vertices.push_back(m_geometry.positions[vIdx]);
+                reducedMesh.normals.push_back(computeCachedVertexNormal(vIdx));
             }
 
             reducedMesh.indices.push_back(vertexIDs[vIdx]);
@@ -332,3 +1211,15 @@ Mesh::SubMesh ReducibleDirectedEdgeMesh::getReducedSubMesh()
 
     return reducedMesh;
 }
+
+template<class TCostPolicy>
+glm::vec3 BasicReducibleDirectedEdgeMesh<TCostPolicy>::computeCachedVertexNormal(VertexIndex vIdx) const
+{
+    glm::vec3 normal(0.f);
+    forEachAdjacentFace(vIdx, [this, &normal](FaceIndex faceIdx) { normal += m_faceNormals[faceIdx]; });
+
+    return glm::normalize(normal);
+}
+
+template class BasicReducibleDirectedEdgeMesh<MelaxCostPolicy>;
+template class BasicReducibleDirectedEdgeMesh<QuadricCostPolicy>;
@@ -1,7 +1,13 @@
 #pragma once
 #include <vector>
+#include <random>
+#include <limits>
 #include "DirectedEdgeMesh.h"
+#include "CollapseCostPolicies.h"
 #include <engine/util/math.h>
+#include <engine/util/IndexedDaryHeap.h>
+#include <engine/util/LazyInvalidationHeap.h>
+#include <engine/util/ThreadPool.h>
 
 struct EdgeCollapseCandidate
 {
@@ -9,8 +15,7 @@ struct EdgeCollapseCandidate
     {
         bool operator()(const EdgeCollapseCandidate& lhs, const EdgeCollapseCandidate& rhs) const
         {
-            // It's important here to sort the values by cost and the edgeIdx to make them unique 
-            // and thus avoid erasing multiple elements.
+            // Ties are broken by the edgeIdx to get a strict ordering and thus a deterministic collapse order.
             if (lhs.cost != rhs.cost)
                 return lhs.cost < rhs.cost;
 
@@ -18,6 +23,11 @@ struct EdgeCollapseCandidate
         }
     };
 
+    struct Key
+    {
+        size_t operator()(const EdgeCollapseCandidate& c) const { return size_t(c.edgeIdx); }
+    };
+
     EdgeCollapseCandidate() {}
     EdgeCollapseCandidate(EdgeID edgeIdx, uint32_t cost)
         : edgeIdx(edgeIdx), cost(cost) {}
@@ -26,43 +36,220 @@ struct EdgeCollapseCandidate
     uint32_t cost{ 0 };
 };
 
-using EdgeCollapseCandidateContainer = std::set<EdgeCollapseCandidate, EdgeCollapseCandidate::Compare>;
+using EdgeCollapseCandidateContainer = IndexedDaryHeap<EdgeCollapseCandidate, EdgeCollapseCandidate::Compare, EdgeCollapseCandidate::Key>;
+using LazyEdgeCollapseCandidateContainer = LazyInvalidationHeap<EdgeCollapseCandidate, EdgeCollapseCandidate::Compare, EdgeCollapseCandidate::Key>;
+
+struct ParallelReductionSettings
+{
+    // Candidates with a cost up to (1 + costTolerance) * minimum cost of a round are collapsed in the same round.
+    // 0 only collapses candidates with the same cost together.
+    float costTolerance{ 0.05f };
+    // Maximum number of collapses per round
+    size_t maxBatchSize{ 4096 };
+};
+
+struct ErrorBoundedReductionSettings
+{
+    // The reduction stops before a collapse with a larger geometric error (see TCostPolicy::toError).
+    float maxCollapseError{ std::numeric_limits<float>::max() };
+    // The reduction stops before the sum of the collapse errors exceeds this value.
+    // The sum is a heuristic budget, not a bound of the deviation from the unreduced mesh: the errors of the policies
+    // aren't distances to the original surface (Melax is length times curvature, QEM an area weighted squared distance).
+    float maxAccumulatedError{ std::numeric_limits<float>::max() };
+};
+
+enum class CandidateQueueMode
+{
+    // Candidates are updated and removed in place.
+    IndexedHeap,
+    // Updates push a new entry, outdated entries are invalidated by per-edge generation counters
+    // and discarded when they are popped.
+    LazyHeap,
+    // No candidate queue: every reduction step samples a few random candidates and collapses the cheapest one
+    // (multiple choice decimation by Wu and Kobbelt). The collapse order is not strictly greedy but neighbors
+    // are never reevaluated. Not supported by reduceRound().
+    MultipleChoice,
+    // No candidates: the mesh is only changed with collapse() and split(), e.g. to replay a stored collapse sequence.
+    // reduce() returns -1.
+    None
+};
+
+enum class LodThresholdType
+{
+    // Fraction of the faces of the mesh before the reduction
+    FaceRatio,
+    // Maximum geometric error of a collapse (see TCostPolicy::toError)
+    Error
+};
 
-class ReducibleDirectedEdgeMesh : public DirectedEdgeMesh
+/**
+* The cost of an edge collapse is computed by TCostPolicy (see CollapseCostPolicies.h).
+* Definitions are in the .cpp file and explicitly instantiated for the available policies.
+*/
+template<class TCostPolicy>
+class BasicReducibleDirectedEdgeMesh : public DirectedEdgeMesh
 {
+    // isValidCollapseCandidate caches the neighbors of vertices up to this valence on the stack.
+    static const uint32_t MAX_CACHED_VALENCE = 32;
+    // reduceRound() doesn't split the collapses of a round into smaller chunks.
+    static const size_t MIN_COLLAPSES_PER_CHUNK = 64;
+    // CandidateQueueMode::MultipleChoice: number of random picks per valid sample before the valid edges are searched
+    static const uint32_t MAX_ATTEMPTS_PER_SAMPLE = 8;
 public:
-    explicit ReducibleDirectedEdgeMesh(const Mesh::SubMesh& subMesh);
-    ReducibleDirectedEdgeMesh() {}
+    using CostPolicy = TCostPolicy;
+
+    /**
+    * Copies of the mesh share the immutable geometry and only copy the topology and the reduction state.
+    */
+    explicit BasicReducibleDirectedEdgeMesh(const GeometryView& geometry, CandidateQueueMode queueMode = CandidateQueueMode::IndexedHeap);
+    explicit BasicReducibleDirectedEdgeMesh(const Mesh::SubMesh& subMesh, CandidateQueueMode queueMode = CandidateQueueMode::IndexedHeap);
+    // See DirectedEdgeMesh: uses the stored opposite halfedges instead of matching them.
+    BasicReducibleDirectedEdgeMesh(const GeometryView& geometry, const EdgeID* opposites, size_t nonManifoldEdgeCount,
+                                   CandidateQueueMode queueMode = CandidateQueueMode::IndexedHeap);
+    // See DirectedEdgeMesh: copies the given connectivity (e.g. of a MeshFile) instead of building it.
+    BasicReducibleDirectedEdgeMesh(const GeometryView& geometry, const TopologyView& topology,
+                                   CandidateQueueMode queueMode = CandidateQueueMode::IndexedHeap);
+    BasicReducibleDirectedEdgeMesh() {}
 
     /**
-    * The cost of a halfedge collapse is computed with the formula from the paper
-    * "A Simple, Fast, and Effective Polygon Reduction Algorithm" by Stan Melax
+    * Returns the cost to collapse the start vertex of the edge into its end vertex.
     */
-    uint32_t computeCost(EdgeID edgeIdx);
+    uint32_t computeCost(EdgeID edgeIdx) const { return m_costPolicy.computeCost(*this, edgeIdx); }
 
     /**
     * Collapses the given edge.
     * 1 vertex, 3 edges and 2 faces are removed if the operation is successful.
     * The given edgeIdx must be a valid collapse candidate.
+    * No memory is allocated unless a border vertex needs more space for its emanating edges.
     */
     void collapse(EdgeID edgeIdx);
 
-    bool isValidCollapseCandidate(EdgeID edgeIdx);
-    bool isFaceRemoved(FaceIndex faceIdx) { return m_removedFaces[faceIdx]; }
-    bool reachedMaxReduction() const { return m_sortedEdgeCollapseCandidates.size() == 0; }
+    bool isValidCollapseCandidate(EdgeID edgeIdx) const;
+    bool isFaceRemoved(FaceIndex faceIdx) const { return m_removedFaces[faceIdx] != 0; }
+    bool reachedMaxReduction() const { return getCandidateCount() == 0; }
     size_t getFaceCount() const { return m_removedFaces.size() - m_removedFaceCount; }
+    const glm::vec3& getFaceNormal(FaceIndex faceIdx) const { return m_faceNormals[faceIdx]; }
+    // O(1) alternative to valenceOf()
+    uint32_t getValence(VertexIndex vIdx) const { return m_valences[vIdx]; }
+    const TCostPolicy& getCostPolicy() const { return m_costPolicy; }
+
+    /**
+    * CandidateQueueMode::MultipleChoice: reduce() chooses the cheapest of sampleCount random valid candidates.
+    * The same seed results in the same collapse order.
+    */
+    void setMultipleChoiceParameters(uint32_t sampleCount, uint32_t seed) { m_sampleCount = std::max(sampleCount, 1u); m_random.seed(seed); }
+
+    /**
+    * Same as computeVertexNormal but uses the cached face normals.
+    */
+    glm::vec3 computeCachedVertexNormal(VertexIndex vIdx) const;
 
     /**
     * Reduces the mesh by collapsing the lowest cost edge.
     * 1 vertex, 3 edges and 2 faces are removed if the operation is successful.
     * Returns the collapsed EdgeID on success otherwise the mesh can not further be reduced and -1 is returned.
+    * The geometric error of the collapse (see TCostPolicy::toError) is written to outError if it isn't null.
     */
-    EdgeID reduce();
+    EdgeID reduce(float* outError = nullptr);
+
+    /**
+    * Parallel alternative to reduce(): Collects valid low cost candidates (see ParallelReductionSettings)
+    * whose 2-ring neighborhoods don't overlap, collapses them concurrently on ThreadPool::getDefault()
+    * and rescores the affected edges in parallel.
+    * The collapsed edges are appended to outCollapsedEdges (if not null) - collapsing them in this order
+    * with collapse() gives the same mesh.
+    * Returns the number of collapsed edges, 0 if the mesh can not further be reduced.
+    */
+    size_t reduceRound(const ParallelReductionSettings& settings = ParallelReductionSettings(), std::vector<EdgeID>* outCollapsedEdges = nullptr);
+
+    /**
+    * Calls reduceRound() until the mesh has at most targetFaceCount faces or can not further be reduced.
+    * Returns the number of collapsed edges.
+    */
+    size_t reduceParallel(size_t targetFaceCount, const ParallelReductionSettings& settings = ParallelReductionSettings(), 
+                          std::vector<EdgeID>* outCollapsedEdges = nullptr);
+
+    /**
+    * Reduces the mesh in the order of reduce() until the next collapse would exceed one of the error bounds
+    * or the mesh can not further be reduced.
+    * The collapsed edges and the error of every collapse are appended to outCollapsedEdges and outCollapseErrors
+    * (if not null) - e.g. to choose level of detail switch distances without evaluating the levels again.
+    * The sum of the errors of this call is written to outAccumulatedError if it isn't null.
+    * Returns the number of collapsed edges.
+    */
+    size_t reduceToError(const ErrorBoundedReductionSettings& settings, std::vector<EdgeID>* outCollapsedEdges = nullptr,
+                         std::vector<float>* outCollapseErrors = nullptr, float* outAccumulatedError = nullptr);
+
+    /**
+    * If enabled every collapse stores a compact record (the changed halfedges and vertices) that split() uses to undo it.
+    * reduceRound() collapses serially while recording. Disabling the recording discards the records.
+    */
+    void setCollapseRecording(bool enabled);
+    size_t getCollapseRecordCount() const { return m_collapseRecords.size(); }
+
+    /**
+    * Undoes the most recently recorded collapse (vertex split) in O(valence) and returns the collapsed edge.
+    * Returns -1 if there is no record. The topology, face normals, valences and the cost policy state are restored exactly,
+    * so moving between two levels of detail costs O(number of collapses between them).
+    * The candidate queue isn't updated - call resetCollapseCandidates() before reducing a split mesh again.
+    */
+    EdgeID split();
+
+    /**
+    * Rebuilds the candidate queue for the current state of the mesh.
+    */
+    void resetCollapseCandidates();
+
+    /**
+    * Generates a chain of discrete levels of detail in a single reduction pass: outLods[i] is a compacted snapshot
+    * (see getReducedSubMesh()) of the first state that reaches thresholds[i]:
+    * - FaceRatio: at most thresholds[i] * getFaceCount() faces
+    * - Error: the state before the first collapse with a larger error
+    * Levels that can't be reached get the maximally reduced mesh. The mesh is left at the coarsest level.
+    * The snapshots are taken from compacted face and vertex lists that are updated per collapse,
+    * so every level costs O(size of the level) instead of a pass over the unreduced mesh.
+    * The collapsed edges are appended to outCollapsedEdges if it isn't null. Returns the number of collapses.
+    */
+    size_t reduceToLods(const std::vector<float>& thresholds, LodThresholdType thresholdType, std::vector<Mesh::SubMesh>& outLods,
+                        std::vector<EdgeID>* outCollapsedEdges = nullptr);
 
     Mesh::SubMesh getReducedSubMesh();
 private:
+    // Initializes the reduction state after the connectivity is built.
+    void init();
+    void initFaceNormals();
+    void initValences();
+    // Flags the vertices of split non-manifold edges.
+    void initNonManifoldVertices();
     // Fills the sorted candidate data structure.
     void initCollapseCandidates();
+    void initLiveFaces();
+    // Finds the next collapse of reduce() - a queue mode removes it from the queue.
+    // Returns false if there is no valid candidate left.
+    bool selectCollapseCandidate(EdgeCollapseCandidate& outCandidate);
+    bool selectMultipleChoiceCandidate(EdgeCollapseCandidate& outCandidate);
+    // Cheapest of m_sampleCount random valid candidates of m_liveFaces or m_validEdges.
+    // Returns false if no valid candidate was found within the attempts or the list is empty.
+    bool sampleLiveFaces(EdgeCollapseCandidate& outCandidate);
+    bool sampleValidEdges(EdgeCollapseCandidate& outCandidate);
+    // Searches all live faces for valid candidates.
+    void collectValidEdges();
+    // Collapses a candidate of selectCollapseCandidate() and reevaluates its neighborhood.
+    void collapseCandidate(EdgeID edgeIdx);
+    // Returns false if the face at the given position of m_liveFaces is removed - it is removed from the list in that case.
+    bool checkLiveFace(size_t pos);
+    // Collapses the edge with the given buffers and returns the number of removed faces.
+    // Collapses of edges with disjoint 2-ring neighborhoods can be executed concurrently
+    // unless requiresSerialCollapse() is true.
+    uint32_t collapse(EdgeID ei, RingScratchArena& scratch);
+    // True if the collapse adds a new border vertex or might move the emanating edge list of a border vertex
+    // which resizes the shared flat array of the lists
+    bool requiresSerialCollapse(EdgeID ei) const;
+    // Appends the edges that need to be reevaluated after the collapse of the given edge.
+    void collectAffectedEdges(EdgeID edgeIdx, std::vector<EdgeID>& outEdges) const;
+    // Marks the 2-ring of the deleted vertex of the edge if the closed 1-ring isn't marked yet.
+    // Returns false if the collapse would conflict with an already marked collapse.
+    bool tryMarkCollapseNeighborhood(EdgeID edgeIdx);
     void deleteEmanatingEdges(VertexIndex vIdx);
     // The data structure stores one emanating edge index per vertex. 
     // During an edge collapse edges are removed however, thus the emanating edge of affected vertices
@@ -70,17 +257,98 @@ private:
     void adjustEmanatingEdgeIndex(VertexIndex vIdx);
     // The cached opposite edge ids of edges that are opposite to removed edges need to be adjusted.
     void adjustOpposites(EdgeID edgeIdx);
+    // Inverse of adjustOpposites: the edges of the removed face still store their old opposites.
+    void restoreOpposites(EdgeID edgeIdx);
 
     void reevaluate(EdgeID edgeIdx);
+
+    // Saves the state that the collapse of the given edge changes and that can't be derived
+    // from the removed faces afterwards. Called at the start of collapse() if recording is enabled.
+    void recordCollapse(EdgeID ei, const std::vector<EdgeID>& emanatingEdges);
+    // Writes the remaining vertex followed by the opposite vertices of the collapse and returns their number.
+    uint32_t getCollapseVertices(EdgeID ei, VertexIndex outVertices[3]) const;
+
+    // Candidate queue operations dispatched by the queue mode
+    void updateCandidate(EdgeID edgeIdx, uint32_t cost);
+    void removeCandidate(EdgeID edgeIdx);
+    EdgeCollapseCandidate popCandidate();
+    size_t getCandidateCount() const;
 private:
     // Faces are just marked as removed for O(1) removal. Vertices and edges still remain in the structure.
-    std::vector<bool> m_removedFaces;
+    // Bytes instead of bits because concurrent collapses write flags of different faces.
+    std::vector<uint8_t> m_removedFaces;
     size_t m_removedFaceCount{ 0 };
-    // Cache costs to allow log(n) retrieval of collapse candidates.
+    // Normalized face normals. They are computed once and only updated for faces that change their shape in collapse().
+    // The index into the vector corresponds to the FaceIndex.
+    std::vector<glm::vec3> m_faceNormals;
+    // Number of neighbors of every vertex - maintained by collapse().
+    // Border vertices are flagged by a negative HalfedgeVertex::id (see isBorderVertex).
+    // The index into the vector corresponds to the VertexIndex.
+    std::vector<uint32_t> m_valences;
+    // Vertices of non-manifold edges (see DirectedEdgeMesh) are never collapsed and never collapsed into:
+    // collapse() and the valence bookkeeping assume that an edge has at most two faces.
+    // Empty if the mesh has no non-manifold edges.
+    std::vector<uint8_t> m_nonManifoldVertices;
+    // Cached costs of the collapse candidates.
     // The index into the vector corresponds to the EdgeID.
     std::vector<uint32_t> m_costs;
-    // Data structure for the edge collapse candidates.
-    // Properties: O(1) access to min cost candidate, log(n) to erase and add a candidate
+    // Data structure for the edge collapse candidates. The heap keeps a position table indexed by EdgeID.
+    // Properties: O(1) access to min cost candidate, log(n) to update or remove a candidate in place without allocations
     // A max mesh decimation is in O(n * log(n)) where n is the number of halfedges
     EdgeCollapseCandidateContainer m_sortedEdgeCollapseCandidates;
+    // Alternative data structure for CandidateQueueMode::LazyHeap.
+    // Properties: O(1) to remove a candidate, log(n) to add a candidate without searching for the old entry
+    LazyEdgeCollapseCandidateContainer m_lazyEdgeCollapseCandidates;
+    CandidateQueueMode m_queueMode{ CandidateQueueMode::IndexedHeap };
+    TCostPolicy m_costPolicy;
+
+    // CandidateQueueMode::MultipleChoice: faces that might not be removed yet. Removed faces are only
+    // swapped out when they are sampled to keep the list out of collapse().
+    std::vector<FaceIndex> m_liveFaces;
+    // Valid candidates of the last search of all faces. Sampled instead of m_liveFaces once the sampling of faces fails,
+    // edges that became invalid are only swapped out when they are sampled.
+    std::vector<EdgeID> m_validEdges;
+    bool m_sampleValidEdges{ false };
+    std::mt19937 m_random;
+    uint32_t m_sampleCount{ 8 };
+    bool m_foundNoCandidate{ false };
+
+    // Buffers of reduceRound(): one scratch arena per chunk and marks of the vertices
+    // in the neighborhoods of the collapses of a round.
+    std::vector<RingScratchArena> m_roundScratch;
+    std::vector<uint32_t> m_vertexMarks;
+    uint32_t m_curVertexMark{ 0 };
+    std::vector<EdgeID> m_roundEdges;
+    std::vector<EdgeID> m_serialRoundEdges;
+    std::vector<EdgeCollapseCandidate> m_deferredCandidates;
+    std::vector<uint8_t> m_affectedEdgeValid;
+    std::vector<uint32_t> m_affectedEdgeCosts;
+
+    // The halfedges of removed faces aren't modified anymore, so the deleted vertex, the remaining vertex,
+    // the opposite vertices and the old opposites of the adjusted edges are read from them in split().
+    struct CollapseRecord
+    {
+        EdgeID edgeIdx{ INVALID_EDGE_ID };
+        // Start of the record in m_collapseRecordEdges: the halfedges that were moved from the deleted vertex
+        // to the remaining vertex followed by the old border lists of the remaining and the opposite vertices.
+        uint32_t edgeOffset{ 0 };
+        uint32_t movedEdgeCount{ 0 };
+        // Sizes of the border list arrays before the collapse. Lists that were added or moved afterwards are discarded.
+        uint32_t borderListCount{ 0 };
+        uint32_t borderEdgeCount{ 0 };
+        // Old state of the remaining vertex (0) and the opposite vertices (1, 2)
+        HalfedgeVertex vertices[3];
+        BorderEdgeList borderLists[3];
+        typename TCostPolicy::UndoData costUndoData;
+    };
+
+    bool m_recordCollapses{ false };
+    std::vector<CollapseRecord> m_collapseRecords;
+    std::vector<EdgeID> m_collapseRecordEdges;
 };
+
+using ReducibleDirectedEdgeMesh = BasicReducibleDirectedEdgeMesh<MelaxCostPolicy>;
+using QuadricReducibleDirectedEdgeMesh = BasicReducibleDirectedEdgeMesh<QuadricCostPolicy>;
+
+extern template class BasicReducibleDirectedEdgeMesh<MelaxCostPolicy>;
+extern template class BasicReducibleDirectedEdgeMesh<QuadricCostPolicy>;
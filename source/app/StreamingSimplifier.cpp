@@ -0,0 +1,335 @@
+#include "StreamingSimplifier.h"
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <limits>
+#include <engine/resource/TriangleStream.h>
+#include <engine/util/Logger.h>
+
+namespace
+{
+    // Triangles per read, the only buffer that is used for the input
+    const size_t BATCH_SIZE = 1 << 16;
+    const uint32_t NO_INDEX = 0xFFFFFFFF;
+    // Below this ratio of the determinant to the cubed mean eigenvalue the quadric of a cell is treated as singular
+    // (a flat or crease cell) and the mean of its corners is used instead of the minimizer.
+    const double SINGULAR_QUADRIC_RATIO = 1e-3;
+
+    /**
+    * Quadric of a cell in double precision relative to the cell origin - planes in absolute float coordinates
+    * of large or far away inputs would lose the precision that the minimizer needs.
+    * Only A and b of the quadric are stored, the constant term doesn't change the minimizer.
+    */
+    struct CellQuadric
+    {
+        // Adds the plane with the unit normal n through p (relative to the cell origin)
+        void addPlane(const glm::dvec3& n, const glm::dvec3& p, double weight)
+        {
+            a += weight * glm::outerProduct(n, n);
+            b += (-weight * glm::dot(n, p)) * n;
+        }
+
+        glm::dmat3 a{ 0.0 };
+        glm::dvec3 b{ 0.0 };
+    };
+
+    struct Cell
+    {
+        CellQuadric quadric;
+        glm::dvec3 cornerSum{ 0.0 };
+        uint32_t cornerCount{ 0 };
+        glm::uvec3 coords;
+    };
+
+    /**
+    * Triangle of cells rotated to start at the smallest cell, so equal triangles with the same orientation compare equal.
+    */
+    struct CellTriangle
+    {
+        CellTriangle(uint32_t c0, uint32_t c1, uint32_t c2)
+        {
+            uint32_t corners[3] = { c0, c1, c2 };
+            int first = (c1 < c0 && c1 < c2) ? 1 : ((c2 < c0 && c2 < c1) ? 2 : 0);
+            for (int i = 0; i < 3; ++i)
+                cells[i] = corners[(first + i) % 3];
+        }
+
+        CellTriangle reversed() const { return CellTriangle(cells[0], cells[2], cells[1]); }
+
+        bool operator==(const CellTriangle& other) const
+        {
+            return cells[0] == other.cells[0] && cells[1] == other.cells[1] && cells[2] == other.cells[2];
+        }
+
+        uint32_t cells[3];
+    };
+
+    struct CellTriangleHash
+    {
+        size_t operator()(const CellTriangle& t) const
+        {
+            return size_t(t.cells[0]) * 73856093u ^ size_t(t.cells[1]) * 19349663u ^ size_t(t.cells[2]) * 83492791u;
+        }
+    };
+
+    /**
+    * Uniform grid over the bounding box of the input that only stores the occupied cells.
+    */
+    class ClusterGrid
+    {
+    public:
+        ClusterGrid(const glm::vec3& boundsMin, const glm::vec3& boundsMax, uint32_t resolution)
+            :m_boundsMin(boundsMin)
+        {
+            glm::vec3 extent = boundsMax - boundsMin;
+            float longestSide = std::max(std::max(extent.x, extent.y), extent.z);
+            m_cellSize = longestSide > 0.0f ? longestSide / float(resolution) : 1.0f;
+
+            for (int i = 0; i < 3; ++i)
+                m_resolution[i] = std::min(std::max(uint32_t(std::ceil(extent[i] / m_cellSize)), 1u), resolution);
+        }
+
+        uint32_t addCorner(const glm::vec3& p)
+        {
+            glm::uvec3 coords;
+            for (int i = 0; i < 3; ++i)
+            {
+                float c = std::floor((p[i] - m_boundsMin[i]) / m_cellSize);
+                coords[i] = c > 0.0f ? std::min(uint32_t(c), m_resolution[i] - 1) : 0;
+            }
+
+            uint64_t key = uint64_t(coords.x) | (uint64_t(coords.y) << 21) | (uint64_t(coords.z) << 42);
+            auto result = m_cellIndices.insert(std::make_pair(key, uint32_t(m_cells.size())));
+            if (result.second)
+            {
+                m_cells.emplace_back();
+                m_cells.back().coords = coords;
+            }
+
+            Cell& cell = m_cells[result.first->second];
+            cell.cornerSum += glm::dvec3(p);
+            ++cell.cornerCount;
+
+            return result.first->second;
+        }
+
+        void addPlane(uint32_t cellIdx, const glm::dvec3& n, const glm::vec3& p, double weight)
+        {
+            Cell& cell = m_cells[cellIdx];
+            cell.quadric.addPlane(n, glm::dvec3(p) - getCellOrigin(cell), weight);
+        }
+
+        size_t getCellCount() const { return m_cells.size(); }
+
+        /**
+        * Minimizes the quadric of the cell in the coordinates of the cell: A * x = -b.
+        * The result is clamped to the cell, so thin features don't create vertices far away from the surface.
+        */
+        glm::vec3 computeRepresentative(uint32_t cellIdx) const
+        {
+            const Cell& cell = m_cells[cellIdx];
+            const glm::dmat3& a = cell.quadric.a;
+            glm::dvec3 origin = getCellOrigin(cell);
+
+            double meanEigenvalue = (a[0][0] + a[1][1] + a[2][2]) / 3.0;
+            double determinant = glm::determinant(a);
+
+            glm::dvec3 p = cell.cornerSum / double(cell.cornerCount) - origin;
+            if (meanEigenvalue > 0.0 && determinant > SINGULAR_QUADRIC_RATIO * meanEigenvalue * meanEigenvalue * meanEigenvalue)
+                p = -(glm::inverse(a) * cell.quadric.b);
+
+            return glm::vec3(origin + glm::clamp(p, glm::dvec3(0.0), glm::dvec3(double(m_cellSize))));
+        }
+
+    private:
+        glm::dvec3 getCellOrigin(const Cell& cell) const
+        {
+            return glm::dvec3(m_boundsMin) + glm::dvec3(cell.coords) * double(m_cellSize);
+        }
+
+    private:
+        glm::vec3 m_boundsMin;
+        float m_cellSize{ 1.0f };
+        glm::uvec3 m_resolution;
+
+        std::unordered_map<uint64_t, uint32_t> m_cellIndices;
+        std::vector<Cell> m_cells;
+    };
+
+    uint32_t findRoot(std::vector<uint32_t>& parents, uint32_t i)
+    {
+        while (parents[i] != i)
+        {
+            parents[i] = parents[parents[i]];
+            i = parents[i];
+        }
+
+        return i;
+    }
+
+    /**
+    * Clustering merges surface parts that only touch in a cell, which creates vertices with several separate fans of faces.
+    * The corners around a vertex are joined across its manifold edges and every additional fan gets a copy of the vertex.
+    */
+    void splitNonManifoldVertices(Mesh::SubMesh& subMesh)
+    {
+        auto& indices = subMesh.indices;
+        size_t cornerCount = indices.size();
+
+        // Halfedge of every directed edge (start corner), NO_INDEX if the directed edge occurs more than once
+        std::unordered_map<uint64_t, uint32_t> halfedges;
+        halfedges.reserve(cornerCount);
+        for (size_t i = 0; i < cornerCount; ++i)
+        {
+            size_t next = i % 3 == 2 ? i - 2 : i + 1;
+            uint64_t key = (uint64_t(indices[i]) << 32) | indices[next];
+            auto result = halfedges.insert(std::make_pair(key, uint32_t(i)));
+            if (!result.second)
+                result.first->second = NO_INDEX;
+        }
+
+        std::vector<uint32_t> parents(cornerCount);
+        for (size_t i = 0; i < cornerCount; ++i)
+            parents[i] = uint32_t(i);
+
+        for (size_t i = 0; i < cornerCount; ++i)
+        {
+            size_t next = i % 3 == 2 ? i - 2 : i + 1;
+            auto edge = halfedges.find((uint64_t(indices[i]) << 32) | indices[next]);
+            auto opposite = halfedges.find((uint64_t(indices[next]) << 32) | indices[i]);
+            if (edge->second == NO_INDEX || opposite == halfedges.end() || opposite->second == NO_INDEX)
+                continue;
+
+            // The opposite halfedge ends at the vertex of corner i
+            uint32_t o = opposite->second;
+            uint32_t oppositeCorner = o % 3 == 2 ? o - 2 : o + 1;
+            parents[findRoot(parents, uint32_t(i))] = findRoot(parents, oppositeCorner);
+        }
+
+        // The first fan of a vertex keeps it
+        std::vector<uint32_t> fanVertices(cornerCount, NO_INDEX);
+        std::vector<bool> vertexUsed(subMesh.vertices.size(), false);
+        size_t splitCount = 0;
+        for (size_t i = 0; i < cornerCount; ++i)
+        {
+            uint32_t root = findRoot(parents, uint32_t(i));
+            if (fanVertices[root] == NO_INDEX)
+            {
+                if (!vertexUsed[indices[i]])
+                {
+                    vertexUsed[indices[i]] = true;
+                    fanVertices[root] = indices[i];
+                }
+                else
+                {
+                    fanVertices[root] = uint32_t(subMesh.vertices.size());
+                    subMesh.vertices.push_back(subMesh.vertices[indices[i]]);
+                    ++splitCount;
+                }
+            }
+
+            indices[i] = fanVertices[root];
+        }
+
+        if (splitCount > 0)
+            Logger::stream() << "Split " << splitCount << " non-manifold vertices of the clustered mesh" << std::endl;
+    }
+}
+
+const uint32_t StreamingSimplifier::MAX_GRID_RESOLUTION;
+
+bool StreamingSimplifier::simplify(const std::string& filename, uint32_t gridResolution, Mesh::SubMesh& outSubMesh)
+{
+    TriangleStream stream;
+    return stream.open(filename) && simplify(stream, gridResolution, outSubMesh);
+}
+
+bool StreamingSimplifier::simplify(TriangleStream& stream, uint32_t gridResolution, Mesh::SubMesh& outSubMesh)
+{
+    gridResolution = std::min(std::max(gridResolution, 1u), MAX_GRID_RESOLUTION);
+    std::vector<glm::vec3> corners(3 * BATCH_SIZE);
+
+    glm::vec3 boundsMin(std::numeric_limits<float>::max());
+    glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
+    size_t triangleCount = 0;
+
+    stream.rewind();
+    for (size_t count = stream.read(corners.data(), BATCH_SIZE); count > 0; count = stream.read(corners.data(), BATCH_SIZE))
+    {
+        for (size_t i = 0; i < 3 * count; ++i)
+        {
+            boundsMin = glm::min(boundsMin, corners[i]);
+            boundsMax = glm::max(boundsMax, corners[i]);
+        }
+
+        triangleCount += count;
+    }
+
+    if (triangleCount == 0)
+    {
+        Logger::stream() << "No triangles in " << stream.getFilename() << std::endl;
+        return false;
+    }
+
+    ClusterGrid grid(boundsMin, boundsMax, gridResolution);
+    std::unordered_set<CellTriangle, CellTriangleHash> triangles;
+
+    stream.rewind();
+    for (size_t count = stream.read(corners.data(), BATCH_SIZE); count > 0; count = stream.read(corners.data(), BATCH_SIZE))
+    {
+        for (size_t t = 0; t < count; ++t)
+        {
+            const glm::vec3* p = &corners[3 * t];
+            uint32_t c0 = grid.addCorner(p[0]);
+            uint32_t c1 = grid.addCorner(p[1]);
+            uint32_t c2 = grid.addCorner(p[2]);
+
+            glm::dvec3 c = glm::cross(glm::dvec3(p[1]) - glm::dvec3(p[0]), glm::dvec3(p[2]) - glm::dvec3(p[0]));
+            double doubleArea = glm::length(c);
+            if (doubleArea > 0.0)
+            {
+                glm::dvec3 n = c / doubleArea;
+                grid.addPlane(c0, n, p[0], 0.5 * doubleArea);
+                grid.addPlane(c1, n, p[0], 0.5 * doubleArea);
+                grid.addPlane(c2, n, p[0], 0.5 * doubleArea);
+            }
+
+            if (c0 == c1 || c1 == c2 || c2 == c0)
+                continue;
+
+            // Opposite faces that collapse onto the same cells (e.g. both sides of a thin wall) would form
+            // a non-manifold double sided triangle, the first one is kept
+            CellTriangle triangle(c0, c1, c2);
+            if (triangles.find(triangle.reversed()) == triangles.end())
+                triangles.insert(triangle);
+        }
+    }
+
+    if (stream.getMalformedFaceCount() > 0)
+        Logger::stream() << "Skipped " << stream.getMalformedFaceCount() << " malformed faces in " << stream.getFilename() << std::endl;
+
+    outSubMesh = Mesh::SubMesh();
+    outSubMesh.indices.reserve(triangles.size() * 3);
+
+    std::vector<uint32_t> cellVertices(grid.getCellCount(), NO_INDEX);
+    for (auto& triangle : triangles)
+    {
+        for (uint32_t cellIdx : triangle.cells)
+        {
+            if (cellVertices[cellIdx] == NO_INDEX)
+            {
+                cellVertices[cellIdx] = uint32_t(outSubMesh.vertices.size());
+                outSubMesh.vertices.push_back(grid.computeRepresentative(cellIdx));
+            }
+
+            outSubMesh.indices.push_back(cellVertices[cellIdx]);
+        }
+    }
+
+    splitNonManifoldVertices(outSubMesh);
+
+    Logger::stream() << "Clustered " << triangleCount << " triangles of " << stream.getFilename() << " into "
+                     << outSubMesh.indices.size() / 3 << " triangles in " << grid.getCellCount() << " cells" << std::endl;
+
+    return true;
+}
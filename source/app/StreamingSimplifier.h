@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <engine/rendering/geometry/Mesh.h>
+
+class TriangleStream;
+
+/**
+* Out-of-core simplification for meshes that don't fit into memory, based on the paper
+* "Out-of-Core Simplification of Large Polygonal Models" by Peter Lindstrom.
+* The triangles are streamed twice from a TriangleStream: the first pass computes the bounding box, the second one
+* clusters the corners in a uniform grid. Every occupied cell accumulates the area weighted quadrics of the triangles
+* that touch it and becomes a single vertex at the position that minimizes its quadric (clamped to the cell).
+* Triangles with corners in three different cells are kept, all others collapse.
+*
+* Only the occupied cells and the kept triangles are held in memory - the working set depends on the grid resolution,
+* not on the size of the input. Non-manifold vertices of the result are split, so it can be loaded into a
+* ReducibleDirectedEdgeMesh to finish the reduction in-core (e.g. after writing it with MeshFile::write).
+*/
+class StreamingSimplifier
+{
+public:
+    // Cell coordinates are packed into 21 bits per axis
+    static const uint32_t MAX_GRID_RESOLUTION = (1 << 21) - 1;
+
+    /**
+    * gridResolution is the number of cells along the longest side of the bounding box. A closed surface keeps about
+    * twice as many triangles as it occupies cells, so doubling the resolution roughly quadruples the result.
+    * Returns false if the file can't be streamed or contains no triangles.
+    */
+    static bool simplify(const std::string& filename, uint32_t gridResolution, Mesh::SubMesh& outSubMesh);
+    static bool simplify(TriangleStream& stream, uint32_t gridResolution, Mesh::SubMesh& outSubMesh);
+};
@@ -1,5 +1,6 @@
 #include "Mesh.h"
 #include <assert.h>
+#include <algorithm>
 #include <engine/util/convert.h>
 #include <engine/util/util.h>
 
@@ -238,6 +239,26 @@ void Mesh::mapToUnitCube()
     finalize();
 }
 
+void Mesh::setDrawIndexCount(size_t indexCount, SubMeshIndex subMeshIdx)
+{
+    ensureCapacity(subMeshIdx);
+    m_subMeshRenderData[subMeshIdx].drawIndexCount = indexCount;
+}
+
+void Mesh::updateIndices(const IndexType* indices, size_t offset, size_t count, SubMeshIndex subMeshIdx)
+{
+    auto& subMesh = m_subMeshes[subMeshIdx];
+    auto& renderData = m_subMeshRenderData[subMeshIdx];
+    assert(offset + count <= subMesh.indices.size() && renderData.ibo != 0);
+
+    std::copy(indices, indices + count, subMesh.indices.begin() + offset);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, renderData.ibo);
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset * sizeof(IndexType), count * sizeof(IndexType), indices);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    GL_ERROR_CHECK();
+}
+
 void Mesh::bindAndRender()
 {
     for (SubMeshIndex i = 0; i < m_subMeshes.size(); ++i)
@@ -256,7 +277,7 @@ void Mesh::bindAndRender()
         }
 
         if (subMesh.indices.size() > 0)
-            glDrawElements(renderData.renderMode, GLsizei(subMesh.indices.size()), GL_UNSIGNED_INT, nullptr);
+            glDrawElements(renderData.renderMode, GLsizei(std::min(subMesh.indices.size(), renderData.drawIndexCount)), GL_UNSIGNED_INT, nullptr);
         else
             glDrawArrays(renderData.renderMode, 0, GLsizei(subMesh.vertices.size()));
     }
@@ -2,6 +2,7 @@
 #include <GL/glew.h>
 #include <string>
 #include <vector>
+#include <limits>
 #include <engine/util/Logger.h>
 
 #define VERTEX_POS 0
@@ -39,6 +40,8 @@ public:
         GLuint ibo{ 0 };
         GLuint vao{ 0 };
         GLenum renderMode{ GL_TRIANGLES };
+        // Only this prefix of the indices is drawn (all if it's larger than the number of indices).
+        size_t drawIndexCount{ std::numeric_limits<size_t>::max() };
     };
 
     class Builder
@@ -123,6 +126,16 @@ public:
     void setUVs(UVs uvs, SubMeshIndex subMeshIdx);
     void setColors(Colors colors, SubMeshIndex subMeshIdx);
     void setRenderMode(GLenum renderMode, SubMeshIndex subMeshIdx);
+
+    /**
+    * Only the first indexCount indices of the sub mesh are drawn, e.g. to switch the level of detail of a progressive mesh.
+    */
+    void setDrawIndexCount(size_t indexCount, SubMeshIndex subMeshIdx);
+
+    /**
+    * Replaces the indices [offset, offset + count) of a finalized sub mesh and uploads only this range.
+    */
+    void updateIndices(const IndexType* indices, size_t offset, size_t count, SubMeshIndex subMeshIdx);
     void setSubMesh(const SubMesh& subMesh, SubMeshIndex subMeshIdx);
     void finalize();
 
@@ -0,0 +1,417 @@
+#include "AssetExporter.h"
+#include <fstream>
+#include <cstring>
+#include <cmath>
+#include <engine/util/Logger.h>
+#include <engine/util/ThreadPool.h>
+
+namespace
+{
+    const size_t WRITE_BUFFER_SIZE = 1 << 22;
+    // Number of lines that are formatted by one task in parallel mode
+    const size_t LINES_PER_BLOCK = 1 << 15;
+    // Upper bounds of the formatted lines
+    const size_t MAX_FLOAT_SIZE = 16;
+    const size_t MAX_UINT_SIZE = 10;
+    const size_t MAX_ATTRIBUTE_LINE_SIZE = 3 + 3 * (MAX_FLOAT_SIZE + 1);
+    const size_t MAX_FACE_LINE_SIZE = 2 + 3 * (3 * MAX_UINT_SIZE + 3);
+
+    static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "Positions are written as 3 floats");
+    static_assert(sizeof(IndexType) == sizeof(uint32_t), "Indices are written as uint32");
+
+    /**
+    * Collects small writes in a large buffer. Every write is preceded by reserve() with an upper bound of its size.
+    */
+    class BufferedFileWriter
+    {
+    public:
+        explicit BufferedFileWriter(const std::string& path)
+            :m_stream(path, std::ios::binary | std::ios::trunc)
+        {
+            m_buffer.resize(WRITE_BUFFER_SIZE);
+        }
+
+        bool isOpen() const { return m_stream.is_open(); }
+
+        char* reserve(size_t size)
+        {
+            if (m_size + size > m_buffer.size())
+            {
+                flush();
+                if (size > m_buffer.size())
+                    m_buffer.resize(size);
+            }
+
+            return m_buffer.data() + m_size;
+        }
+
+        void commit(size_t size) { m_size += size; }
+
+        void write(const void* data, size_t size)
+        {
+            // Large blocks bypass the buffer
+            if (size >= m_buffer.size() / 2)
+            {
+                flush();
+                m_stream.write(static_cast<const char*>(data), std::streamsize(size));
+                return;
+            }
+
+            std::memcpy(reserve(size), data, size);
+            commit(size);
+        }
+
+        void write(const std::string& s) { write(s.data(), s.size()); }
+
+        bool finish()
+        {
+            flush();
+            m_stream.flush();
+            return m_stream.good();
+        }
+
+    private:
+        void flush()
+        {
+            m_stream.write(m_buffer.data(), std::streamsize(m_size));
+            m_size = 0;
+        }
+
+    private:
+        std::ofstream m_stream;
+        std::vector<char> m_buffer;
+        size_t m_size{ 0 };
+    };
+
+    double powerOf10(int exponent)
+    {
+        // Covers the float range including the 9 significant digits
+        static const int MIN_EXPONENT = -64;
+        static const int MAX_EXPONENT = 64;
+        static const std::vector<double> powers = []()
+        {
+            std::vector<double> p(MAX_EXPONENT - MIN_EXPONENT + 1);
+            for (int e = MIN_EXPONENT; e <= MAX_EXPONENT; ++e)
+                p[e - MIN_EXPONENT] = std::pow(10.0, double(e));
+            return p;
+        }();
+
+        return powers[std::min(std::max(exponent, MIN_EXPONENT), MAX_EXPONENT) - MIN_EXPONENT];
+    }
+
+    size_t formatUInt(uint64_t value, char* out)
+    {
+        char digits[20];
+        size_t count = 0;
+        do
+        {
+            digits[count++] = char('0' + value % 10);
+            value /= 10;
+        } while (value > 0);
+
+        for (size_t i = 0; i < count; ++i)
+            out[i] = digits[count - 1 - i];
+
+        return count;
+    }
+
+    /**
+    * Writes at most MAX_FLOAT_SIZE characters: 9 significant digits without trailing zeros,
+    * in fixed notation for exponents in [-5, 8] and in scientific notation otherwise.
+    */
+    size_t formatFloat(float value, char* out)
+    {
+        char* p = out;
+
+        if (std::isnan(value))
+        {
+            std::memcpy(p, "nan", 3);
+            return 3;
+        }
+
+        if (std::signbit(value))
+        {
+            *p++ = '-';
+            value = -value;
+        }
+
+        if (std::isinf(value))
+        {
+            std::memcpy(p, "inf", 3);
+            return size_t(p - out) + 3;
+        }
+
+        if (value == 0.0f)
+        {
+            *p++ = '0';
+            return size_t(p - out);
+        }
+
+        double v = value;
+        int exponent = int(std::floor(std::log10(v)));
+        uint64_t mantissa = uint64_t(std::llround(v * powerOf10(8 - exponent)));
+
+        // log10 can be off by one at powers of 10 and rounding can carry into a 10th digit
+        if (mantissa >= 1000000000ull)
+            mantissa = uint64_t(std::llround(v * powerOf10(8 - ++exponent)));
+        else if (mantissa < 100000000ull)
+            mantissa = uint64_t(std::llround(v * powerOf10(8 - --exponent)));
+
+        int digitCount = 9;
+        while (digitCount > 1 && mantissa % 10 == 0)
+        {
+            mantissa /= 10;
+            --digitCount;
+        }
+
+        char digits[9];
+        formatUInt(mantissa, digits);
+
+        if (exponent >= -5 && exponent <= 8)
+        {
+            if (exponent < 0)
+            {
+                *p++ = '0';
+                *p++ = '.';
+                for (int i = 0; i < -exponent - 1; ++i)
+                    *p++ = '0';
+
+                std::memcpy(p, digits, size_t(digitCount));
+                return size_t(p - out) + size_t(digitCount);
+            }
+
+            int integerDigits = exponent + 1;
+            for (int i = 0; i < integerDigits; ++i)
+                *p++ = i < digitCount ? digits[i] : '0';
+
+            if (digitCount > integerDigits)
+            {
+                *p++ = '.';
+                std::memcpy(p, digits + integerDigits, size_t(digitCount - integerDigits));
+                p += digitCount - integerDigits;
+            }
+
+            return size_t(p - out);
+        }
+
+        *p++ = digits[0];
+        if (digitCount > 1)
+        {
+            *p++ = '.';
+            std::memcpy(p, digits + 1, size_t(digitCount - 1));
+            p += digitCount - 1;
+        }
+
+        *p++ = 'e';
+        if (exponent < 0)
+        {
+            *p++ = '-';
+            exponent = -exponent;
+        }
+
+        p += formatUInt(uint64_t(exponent), p);
+        return size_t(p - out);
+    }
+
+    template<class TVec>
+    size_t formatAttributeLine(const char* keyword, const TVec& v, char* out)
+    {
+        char* p = out;
+        size_t keywordLength = std::strlen(keyword);
+        std::memcpy(p, keyword, keywordLength);
+        p += keywordLength;
+
+        for (int i = 0; i < v.length(); ++i)
+        {
+            *p++ = ' ';
+            p += formatFloat(v[i], p);
+        }
+
+        *p++ = '\n';
+        return size_t(p - out);
+    }
+
+    /**
+    * Writes formatLine(i, out) for every i in [0, count). formatLine returns the number of written characters
+    * which must not exceed maxLineSize. In parallel mode every thread formats a block of lines into its own buffer
+    * and the blocks are written in order.
+    */
+    template<class TFormatLine>
+    void writeLines(BufferedFileWriter& writer, size_t count, size_t maxLineSize, ExportMode mode, TFormatLine formatLine)
+    {
+        auto& threadPool = ThreadPool::getDefault();
+
+        if (mode == ExportMode::Serial || threadPool.getThreadCount() == 1 || count <= LINES_PER_BLOCK)
+        {
+            for (size_t i = 0; i < count; ++i)
+                writer.commit(formatLine(i, writer.reserve(maxLineSize)));
+
+            return;
+        }
+
+        size_t blocksPerBatch = threadPool.getThreadCount();
+        std::vector<std::vector<char>> blockBuffers(blocksPerBatch, std::vector<char>(LINES_PER_BLOCK * maxLineSize));
+        std::vector<size_t> blockSizes(blocksPerBatch);
+
+        for (size_t batchStart = 0; batchStart < count; batchStart += blocksPerBatch * LINES_PER_BLOCK)
+        {
+            threadPool.run(blocksPerBatch, [&](size_t blockIdx)
+            {
+                size_t begin = std::min(batchStart + blockIdx * LINES_PER_BLOCK, count);
+                size_t end = std::min(begin + LINES_PER_BLOCK, count);
+
+                char* out = blockBuffers[blockIdx].data();
+                size_t size = 0;
+                for (size_t i = begin; i < end; ++i)
+                    size += formatLine(i, out + size);
+
+                blockSizes[blockIdx] = size;
+            });
+
+            for (size_t blockIdx = 0; blockIdx < blocksPerBatch; ++blockIdx)
+                writer.write(blockBuffers[blockIdx].data(), blockSizes[blockIdx]);
+        }
+    }
+
+    bool endsWith(const std::string& s, const std::string& suffix)
+    {
+        return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    bool finishFile(BufferedFileWriter& writer, const std::string& filename)
+    {
+        if (!writer.finish())
+        {
+            Logger::stream() << "Could not write file: " << filename << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+}
+
+bool AssetExporter::exportSubMesh(const std::string& filename, const Mesh::SubMesh& subMesh, ExportMode mode)
+{
+    if (endsWith(filename, ".obj"))
+        return exportObj(filename, subMesh, mode);
+
+    if (endsWith(filename, ".ply"))
+        return exportPly(filename, subMesh);
+
+    SHOW_ERROR("Error: Unknown file format " << filename);
+    return false;
+}
+
+bool AssetExporter::exportObj(const std::string& filename, const Mesh::SubMesh& subMesh, ExportMode mode)
+{
+    BufferedFileWriter writer(filename);
+    if (!writer.isOpen())
+    {
+        Logger::stream() << "Could not open file: " << filename << std::endl;
+        return false;
+    }
+
+    bool hasNormals = !subMesh.normals.empty() && subMesh.normals.size() == subMesh.vertices.size();
+    bool hasUVs = !subMesh.uvs.empty() && subMesh.uvs.size() == subMesh.vertices.size();
+
+    writer.write("# " + std::to_string(subMesh.vertices.size()) + " vertices, " + std::to_string(subMesh.indices.size() / 3) + " faces\n");
+
+    writeLines(writer, subMesh.vertices.size(), MAX_ATTRIBUTE_LINE_SIZE, mode,
+               [&subMesh](size_t i, char* out) { return formatAttributeLine("v", subMesh.vertices[i], out); });
+
+    if (hasUVs)
+    {
+        writeLines(writer, subMesh.uvs.size(), MAX_ATTRIBUTE_LINE_SIZE, mode,
+                   [&subMesh](size_t i, char* out) { return formatAttributeLine("vt", subMesh.uvs[i], out); });
+    }
+
+    if (hasNormals)
+    {
+        writeLines(writer, subMesh.normals.size(), MAX_ATTRIBUTE_LINE_SIZE, mode,
+                   [&subMesh](size_t i, char* out) { return formatAttributeLine("vn", subMesh.normals[i], out); });
+    }
+
+    // Every vertex has all of its attributes, so a corner uses the same number for all of them
+    writeLines(writer, subMesh.indices.size() / 3, MAX_FACE_LINE_SIZE, mode, [&subMesh, hasNormals, hasUVs](size_t faceIdx, char* out)
+    {
+        char* p = out;
+        *p++ = 'f';
+
+        for (size_t c = 0; c < 3; ++c)
+        {
+            uint64_t objIndex = uint64_t(subMesh.indices[faceIdx * 3 + c]) + 1;
+            *p++ = ' ';
+            p += formatUInt(objIndex, p);
+
+            if (hasUVs || hasNormals)
+            {
+                *p++ = '/';
+                if (hasUVs)
+                    p += formatUInt(objIndex, p);
+            }
+
+            if (hasNormals)
+            {
+                *p++ = '/';
+                p += formatUInt(objIndex, p);
+            }
+        }
+
+        *p++ = '\n';
+        return size_t(p - out);
+    });
+
+    return finishFile(writer, filename);
+}
+
+bool AssetExporter::exportPly(const std::string& filename, const Mesh::SubMesh& subMesh)
+{
+    BufferedFileWriter writer(filename);
+    if (!writer.isOpen())
+    {
+        Logger::stream() << "Could not open file: " << filename << std::endl;
+        return false;
+    }
+
+    uint16_t byteOrderTest = 1;
+    uint8_t firstByte;
+    std::memcpy(&firstByte, &byteOrderTest, 1);
+    bool littleEndian = firstByte == 1;
+
+    bool hasNormals = !subMesh.normals.empty() && subMesh.normals.size() == subMesh.vertices.size();
+    size_t faceCount = subMesh.indices.size() / 3;
+
+    std::string header = "ply\nformat ";
+    header += littleEndian ? "binary_little_endian" : "binary_big_endian";
+    header += " 1.0\nelement vertex " + std::to_string(subMesh.vertices.size()) + "\n";
+    header += "property float x\nproperty float y\nproperty float z\n";
+    if (hasNormals)
+        header += "property float nx\nproperty float ny\nproperty float nz\n";
+    header += "element face " + std::to_string(faceCount) + "\n";
+    header += "property list uchar int vertex_indices\nend_header\n";
+    writer.write(header);
+
+    if (hasNormals)
+    {
+        for (size_t i = 0; i < subMesh.vertices.size(); ++i)
+        {
+            char* out = writer.reserve(2 * sizeof(glm::vec3));
+            std::memcpy(out, &subMesh.vertices[i], sizeof(glm::vec3));
+            std::memcpy(out + sizeof(glm::vec3), &subMesh.normals[i], sizeof(glm::vec3));
+            writer.commit(2 * sizeof(glm::vec3));
+        }
+    }
+    else
+        writer.write(subMesh.vertices.data(), subMesh.vertices.size() * sizeof(glm::vec3));
+
+    const size_t faceSize = 1 + 3 * sizeof(uint32_t);
+    for (size_t i = 0; i < faceCount; ++i)
+    {
+        char* out = writer.reserve(faceSize);
+        out[0] = 3;
+        std::memcpy(out + 1, &subMesh.indices[i * 3], 3 * sizeof(uint32_t));
+        writer.commit(faceSize);
+    }
+
+    return finishFile(writer, filename);
+}
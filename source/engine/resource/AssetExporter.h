@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+#include <engine/rendering/geometry/Mesh.h>
+
+enum class ExportMode
+{
+    // The text is formatted on the calling thread
+    Serial,
+    // Blocks of vertices and faces are formatted concurrently on ThreadPool::getDefault() and written in order
+    Parallel
+};
+
+/**
+* Writes sub meshes (e.g. ReducibleDirectedEdgeMesh::getReducedSubMesh()) through a large write buffer.
+* Normals and texture coordinates are written if there is one per vertex.
+* The native format is written by MeshFile::write.
+*/
+class AssetExporter
+{
+public:
+    /**
+    * Chooses the format by the file extension (.obj or .ply). Returns false if the file can't be written.
+    */
+    static bool exportSubMesh(const std::string& filename, const Mesh::SubMesh& subMesh, ExportMode mode = ExportMode::Parallel);
+
+    /**
+    * Floats are written with 9 significant digits, so they are read back exactly.
+    */
+    static bool exportObj(const std::string& filename, const Mesh::SubMesh& subMesh, ExportMode mode = ExportMode::Parallel);
+
+    /**
+    * Binary PLY in the byte order of the host.
+    */
+    static bool exportPly(const std::string& filename, const Mesh::SubMesh& subMesh);
+};
@@ -1,10 +1,11 @@
 #pragma once
 #include <memory>
 #include "Model.h"
+#include "ObjImporter.h"
 
 class AssetImporter
 {
 public:
-    static std::shared_ptr<Model> import(const std::string& filename);
-    static std::shared_ptr<Model> importObjPositions(const std::string& filename);
+    static std::shared_ptr<Model> import(const std::string& filename, ObjImportMode mode = ObjImportMode::Parallel);
+    static std::shared_ptr<Model> importObjPositions(const std::string& filename, ObjImportMode mode = ObjImportMode::Parallel);
 };
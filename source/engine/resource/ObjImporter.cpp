@@ -0,0 +1,390 @@
+#include "ObjImporter.h"
+#include "ObjScanner.h"
+#include <unordered_map>
+#include <cstring>
+#include <engine/util/file.h>
+#include <engine/util/Logger.h>
+#include <engine/util/ThreadPool.h>
+
+namespace
+{
+    // Smaller files are parsed as a single chunk
+    const size_t MIN_CHUNK_SIZE = 1 << 20;
+    // More chunks than threads balance chunks that contain different kinds of records
+    const size_t CHUNKS_PER_THREAD = 4;
+
+    struct ObjCorner
+    {
+        bool operator==(const ObjCorner& other) const
+        {
+            return position == other.position && texCoord == other.texCoord && normal == other.normal;
+        }
+
+        uint32_t position{ 0 };
+        uint32_t texCoord{ NO_ATTRIBUTE };
+        uint32_t normal{ NO_ATTRIBUTE };
+
+        static const uint32_t NO_ATTRIBUTE = 0xFFFFFFFF;
+    };
+
+    struct ObjCornerHash
+    {
+        size_t operator()(const ObjCorner& c) const
+        {
+            return size_t(c.position) * 73856093u ^ size_t(c.texCoord) * 19349663u ^ size_t(c.normal) * 83492791u;
+        }
+    };
+
+    struct ObjRecordCounts
+    {
+        size_t positions{ 0 };
+        size_t texCoords{ 0 };
+        size_t normals{ 0 };
+    };
+
+    // Output arrays of the attribute records, records without an array are only counted
+    struct ObjAttributes
+    {
+        glm::vec3* positions{ nullptr };
+        glm::vec2* texCoords{ nullptr };
+        glm::vec3* normals{ nullptr };
+    };
+
+    struct ObjChunk
+    {
+        const char* begin{ nullptr };
+        const char* end{ nullptr };
+
+        ObjRecordCounts counts;
+        // Global number of the first record of every type in this chunk - the prefix sum of the counts
+        ObjRecordCounts first;
+
+        // Faces as resolved corners and the number of corners of every face (import)
+        // or as fan triangulated position indices (importPositions)
+        std::vector<ObjCorner> corners;
+        std::vector<uint32_t> faceSizes;
+        std::vector<uint32_t> indices;
+        // Start of the indices of this chunk in the output
+        size_t indexOffset{ 0 };
+
+        size_t malformedLineCount{ 0 };
+    };
+
+    template<class TFunc>
+    void forEachChunk(std::vector<ObjChunk>& chunks, ObjImportMode mode, TFunc func)
+    {
+        if (mode == ObjImportMode::Parallel)
+        {
+            ThreadPool::getDefault().run(chunks.size(), [&chunks, &func](size_t chunkIdx) { func(chunks[chunkIdx]); });
+            return;
+        }
+
+        for (auto& chunk : chunks)
+            func(chunk);
+    }
+
+    // Chunks start at the beginning of a line and end after a line break or at the end of the file.
+    void splitIntoChunks(const char* data, size_t size, size_t chunkCount, std::vector<ObjChunk>& outChunks)
+    {
+        outChunks.resize(chunkCount);
+
+        const char* begin = data;
+        const char* end = data + size;
+        for (size_t i = 0; i < chunkCount; ++i)
+        {
+            const char* chunkEnd = end;
+            if (i + 1 < chunkCount)
+            {
+                chunkEnd = std::max(data + (i + 1) * size / chunkCount, begin + 1) - 1;
+                auto lineEnd = chunkEnd < end ? static_cast<const char*>(std::memchr(chunkEnd, '\n', size_t(end - chunkEnd))) : nullptr;
+                chunkEnd = lineEnd ? lineEnd + 1 : end;
+            }
+
+            outChunks[i].begin = begin;
+            outChunks[i].end = chunkEnd;
+            begin = chunkEnd;
+        }
+    }
+
+    void countRecords(ObjChunk& chunk)
+    {
+        ObjScanner scanner(chunk.begin, chunk.end);
+        while (!scanner.atEnd())
+        {
+            switch (scanner.readRecordType())
+            {
+            case ObjRecordType::Position:
+                ++chunk.counts.positions;
+                break;
+            case ObjRecordType::TexCoord:
+                ++chunk.counts.texCoords;
+                break;
+            case ObjRecordType::Normal:
+                ++chunk.counts.normals;
+                break;
+            default:
+                break;
+            }
+
+            scanner.skipLine();
+        }
+    }
+
+    // The value is only written if the record is valid, so malformed records stay zero.
+    bool readVec3(ObjScanner& scanner, glm::vec3* outValue)
+    {
+        glm::vec3 v;
+        if (!scanner.readFloat(v.x) || !scanner.readFloat(v.y) || !scanner.readFloat(v.z))
+            return false;
+
+        if (outValue)
+            *outValue = v;
+
+        return true;
+    }
+
+    bool readVec2(ObjScanner& scanner, glm::vec2* outValue)
+    {
+        glm::vec2 v;
+        if (!scanner.readFloat(v.x) || !scanner.readFloat(v.y))
+            return false;
+
+        if (outValue)
+            *outValue = v;
+
+        return true;
+    }
+
+    // Relative indices refer to the records read so far (curCounts), absolute indices to all records of the file.
+    bool resolveIndex(int64_t objIndex, size_t curCount, size_t totalCount, uint32_t& outIndex)
+    {
+        return ObjScanner::resolveIndex(objIndex, objIndex < 0 ? curCount : totalCount, outIndex);
+    }
+
+    // Reads the corners of a face record. A missing attribute of a corner is set to ObjCorner::NO_ATTRIBUTE.
+    // Returns false if an index is out of range or the face has less than 3 corners.
+    bool readFace(ObjScanner& scanner, const ObjRecordCounts& curCounts, const ObjRecordCounts& totalCounts, std::vector<ObjCorner>& outCorners)
+    {
+        outCorners.clear();
+
+        while (!scanner.atLineEnd())
+        {
+            int64_t position, texCoord, normal;
+            if (!scanner.readFaceCorner(position, texCoord, normal))
+                return false;
+
+            ObjCorner corner;
+            if (!resolveIndex(position, curCounts.positions, totalCounts.positions, corner.position))
+                return false;
+            if (texCoord != ObjScanner::NO_INDEX && !resolveIndex(texCoord, curCounts.texCoords, totalCounts.texCoords, corner.texCoord))
+                return false;
+            if (normal != ObjScanner::NO_INDEX && !resolveIndex(normal, curCounts.normals, totalCounts.normals, corner.normal))
+                return false;
+
+            outCorners.push_back(corner);
+        }
+
+        return outCorners.size() >= 3;
+    }
+
+    void parseChunk(ObjChunk& chunk, const ObjRecordCounts& totalCounts, const ObjAttributes& attributes, bool positionsOnly)
+    {
+        ObjRecordCounts curCounts = chunk.first;
+        std::vector<ObjCorner> faceCorners;
+
+        ObjScanner scanner(chunk.begin, chunk.end);
+        while (!scanner.atEnd())
+        {
+            bool valid = true;
+
+            switch (scanner.readRecordType())
+            {
+            case ObjRecordType::Position:
+                valid = readVec3(scanner, attributes.positions ? &attributes.positions[curCounts.positions] : nullptr);
+                ++curCounts.positions;
+                break;
+            case ObjRecordType::TexCoord:
+                valid = !attributes.texCoords || readVec2(scanner, &attributes.texCoords[curCounts.texCoords]);
+                ++curCounts.texCoords;
+                break;
+            case ObjRecordType::Normal:
+                valid = !attributes.normals || readVec3(scanner, &attributes.normals[curCounts.normals]);
+                ++curCounts.normals;
+                break;
+            case ObjRecordType::Face:
+                valid = readFace(scanner, curCounts, totalCounts, faceCorners);
+                if (!valid)
+                    break;
+
+                if (positionsOnly)
+                {
+                    for (size_t i = 2; i < faceCorners.size(); ++i)
+                    {
+                        chunk.indices.push_back(faceCorners[0].position);
+                        chunk.indices.push_back(faceCorners[i - 1].position);
+                        chunk.indices.push_back(faceCorners[i].position);
+                    }
+                }
+                else
+                {
+                    chunk.corners.insert(chunk.corners.end(), faceCorners.begin(), faceCorners.end());
+                    chunk.faceSizes.push_back(uint32_t(faceCorners.size()));
+                }
+                break;
+            default:
+                break;
+            }
+
+            if (!valid)
+                ++chunk.malformedLineCount;
+
+            scanner.skipLine();
+        }
+    }
+
+    // Maps the file, splits it into chunks and numbers the records of the chunks.
+    bool prepareChunks(const std::string& filename, ObjImportMode mode, file::MappedFile& mappedFile,
+                       std::vector<ObjChunk>& outChunks, ObjRecordCounts& outTotalCounts)
+    {
+        if (!mappedFile.open(filename))
+        {
+            Logger::stream() << "Could not open file: " << filename << std::endl;
+            return false;
+        }
+
+        size_t chunkCount = 1;
+        if (mode == ObjImportMode::Parallel)
+        {
+            size_t maxChunkCount = ThreadPool::getDefault().getThreadCount() * CHUNKS_PER_THREAD;
+            chunkCount = std::max(std::min(maxChunkCount, mappedFile.size() / MIN_CHUNK_SIZE), size_t(1));
+        }
+
+        splitIntoChunks(mappedFile.data(), mappedFile.size(), chunkCount, outChunks);
+        forEachChunk(outChunks, mode, countRecords);
+
+        outTotalCounts = ObjRecordCounts();
+        for (auto& chunk : outChunks)
+        {
+            chunk.first = outTotalCounts;
+            outTotalCounts.positions += chunk.counts.positions;
+            outTotalCounts.texCoords += chunk.counts.texCoords;
+            outTotalCounts.normals += chunk.counts.normals;
+        }
+
+        return true;
+    }
+
+    void logMalformedLines(const std::string& filename, const std::vector<ObjChunk>& chunks)
+    {
+        size_t malformedLineCount = 0;
+        for (auto& chunk : chunks)
+            malformedLineCount += chunk.malformedLineCount;
+
+        if (malformedLineCount > 0)
+            Logger::stream() << "Skipped " << malformedLineCount << " malformed lines in " << filename << std::endl;
+    }
+}
+
+std::shared_ptr<Model> ObjImporter::import(const std::string& filename, ObjImportMode mode)
+{
+    std::shared_ptr<Model> model = std::make_shared<Model>();
+    model->subMeshes.resize(1);
+    auto& subMesh = model->subMeshes[0];
+
+    file::MappedFile mappedFile;
+    std::vector<ObjChunk> chunks;
+    ObjRecordCounts totalCounts;
+    if (!prepareChunks(filename, mode, mappedFile, chunks, totalCounts))
+        return model;
+
+    std::vector<glm::vec3> positions(totalCounts.positions);
+    std::vector<glm::vec2> uvs(totalCounts.texCoords);
+    std::vector<glm::vec3> normals(totalCounts.normals);
+
+    ObjAttributes attributes;
+    attributes.positions = positions.data();
+    attributes.texCoords = uvs.data();
+    attributes.normals = normals.data();
+    forEachChunk(chunks, mode, [&totalCounts, &attributes](ObjChunk& chunk) { parseChunk(chunk, totalCounts, attributes, false); });
+
+    // Vertices are created in the order of the first reference of their corner. This only hashes integers,
+    // so it is cheap compared to parsing and stays serial to keep the vertex order of the file.
+    std::unordered_map<ObjCorner, uint32_t, ObjCornerHash> vertexHashMap;
+    std::vector<uint32_t> vertexIndices;
+
+    for (auto& chunk : chunks)
+    {
+        size_t cornerIdx = 0;
+        for (uint32_t faceSize : chunk.faceSizes)
+        {
+            vertexIndices.clear();
+            for (uint32_t i = 0; i < faceSize; ++i)
+            {
+                auto& corner = chunk.corners[cornerIdx++];
+                auto it = vertexHashMap.find(corner);
+
+                if (it != vertexHashMap.end())
+                    vertexIndices.push_back(it->second);
+                else
+                {
+                    subMesh.vertices.push_back(positions[corner.position]);
+                    if (corner.texCoord != ObjCorner::NO_ATTRIBUTE)
+                        subMesh.uvs.push_back(uvs[corner.texCoord]);
+                    if (corner.normal != ObjCorner::NO_ATTRIBUTE)
+                        subMesh.normals.push_back(normals[corner.normal]);
+
+                    vertexIndices.push_back(static_cast<uint32_t>(subMesh.vertices.size() - 1));
+                    vertexHashMap[corner] = vertexIndices.back();
+                }
+            }
+
+            for (size_t i = 2; i < vertexIndices.size(); ++i)
+            {
+                subMesh.indices.push_back(vertexIndices[0]);
+                subMesh.indices.push_back(vertexIndices[i - 1]);
+                subMesh.indices.push_back(vertexIndices[i]);
+            }
+        }
+
+        std::vector<ObjCorner>().swap(chunk.corners);
+    }
+
+    logMalformedLines(filename, chunks);
+    return model;
+}
+
+std::shared_ptr<Model> ObjImporter::importPositions(const std::string& filename, ObjImportMode mode)
+{
+    std::shared_ptr<Model> model = std::make_shared<Model>();
+    model->subMeshes.resize(1);
+    auto& subMesh = model->subMeshes[0];
+
+    file::MappedFile mappedFile;
+    std::vector<ObjChunk> chunks;
+    ObjRecordCounts totalCounts;
+    if (!prepareChunks(filename, mode, mappedFile, chunks, totalCounts))
+        return model;
+
+    // Texture coordinates and normals are only counted to validate the face indices
+    subMesh.vertices.resize(totalCounts.positions);
+    ObjAttributes attributes;
+    attributes.positions = subMesh.vertices.data();
+    forEachChunk(chunks, mode, [&totalCounts, &attributes](ObjChunk& chunk) { parseChunk(chunk, totalCounts, attributes, true); });
+
+    size_t indexCount = 0;
+    for (auto& chunk : chunks)
+    {
+        chunk.indexOffset = indexCount;
+        indexCount += chunk.indices.size();
+    }
+
+    subMesh.indices.resize(indexCount);
+    forEachChunk(chunks, mode, [&subMesh](ObjChunk& chunk)
+    {
+        std::copy(chunk.indices.begin(), chunk.indices.end(), subMesh.indices.begin() + chunk.indexOffset);
+        std::vector<uint32_t>().swap(chunk.indices);
+    });
+
+    logMalformedLines(filename, chunks);
+    return model;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <memory>
+#include <string>
+#include "Model.h"
+
+enum class ObjImportMode
+{
+    // The file is parsed on the calling thread
+    Serial,
+    // The file is split into newline aligned chunks that are parsed concurrently on ThreadPool::getDefault()
+    Parallel
+};
+
+/**
+* Imports OBJ files from a memory mapping with ObjScanner.
+* Parallel mode: a first pass counts the v/vt/vn records of every chunk, the prefix sums of the counts give
+* every chunk the global number of its first record, so the second pass writes the attributes straight into
+* the output arrays and resolves absolute and relative (negative) indices without waiting for other chunks.
+* Both modes give the same result. Malformed v/vt/vn records keep their number and are set to zero.
+*/
+class ObjImporter
+{
+public:
+    /**
+    * Imports positions, texture coordinates and normals into a single sub mesh.
+    * Vertices are created per unique combination of position, texture coordinate and normal index.
+    */
+    static std::shared_ptr<Model> import(const std::string& filename, ObjImportMode mode = ObjImportMode::Parallel);
+
+    /**
+    * Only imports the positions - vertices correspond to the v records of the file.
+    */
+    static std::shared_ptr<Model> importPositions(const std::string& filename, ObjImportMode mode = ObjImportMode::Parallel);
+};
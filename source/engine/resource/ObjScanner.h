@@ -0,0 +1,259 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <limits>
+
+enum class ObjRecordType
+{
+    Position,
+    TexCoord,
+    Normal,
+    Face,
+    // Comments, empty lines and unsupported records
+    Other
+};
+
+/**
+* Tokenizer for OBJ text that parses numbers in place without allocations.
+* Works on any character range, e.g. a memory mapped file or a chunk of it.
+* Usage: readRecordType(), the read functions for the values of the record and skipLine() to get to the next record.
+*/
+class ObjScanner
+{
+public:
+    // Index of a face corner attribute that isn't specified
+    static const int64_t NO_INDEX = 0;
+
+    ObjScanner(const char* begin, const char* end)
+        :m_cur(begin), m_end(end) {}
+
+    bool atEnd() const { return m_cur >= m_end; }
+    const char* position() const { return m_cur; }
+
+    /**
+    * Skips spaces, tabs and carriage returns but not line breaks.
+    */
+    void skipSpaces()
+    {
+        while (m_cur < m_end && (*m_cur == ' ' || *m_cur == '\t' || *m_cur == '\r'))
+            ++m_cur;
+    }
+
+    /**
+    * Moves to the start of the next line.
+    */
+    void skipLine()
+    {
+        const char* lineEnd = static_cast<const char*>(std::memchr(m_cur, '\n', size_t(m_end - m_cur)));
+        m_cur = lineEnd ? lineEnd + 1 : m_end;
+    }
+
+    /**
+    * True if there are no more values in the current line.
+    */
+    bool atLineEnd()
+    {
+        skipSpaces();
+        return m_cur >= m_end || *m_cur == '\n' || *m_cur == '#';
+    }
+
+    /**
+    * Reads the keyword at the start of a line.
+    */
+    ObjRecordType readRecordType()
+    {
+        skipSpaces();
+        const char* keyword = m_cur;
+        while (m_cur < m_end && !isSpace(*m_cur))
+            ++m_cur;
+
+        size_t length = size_t(m_cur - keyword);
+        if (length == 1 && keyword[0] == 'v')
+            return ObjRecordType::Position;
+        if (length == 1 && keyword[0] == 'f')
+            return ObjRecordType::Face;
+        if (length == 2 && keyword[0] == 'v' && keyword[1] == 't')
+            return ObjRecordType::TexCoord;
+        if (length == 2 && keyword[0] == 'v' && keyword[1] == 'n')
+            return ObjRecordType::Normal;
+
+        return ObjRecordType::Other;
+    }
+
+    /**
+    * Reads a decimal floating point number with an optional exponent.
+    * The significant digits are accumulated as an integer and scaled once, which is exact enough for floats.
+    * Returns false if there is no number.
+    */
+    bool readFloat(float& out)
+    {
+        skipSpaces();
+        const char* p = m_cur;
+
+        bool negative = false;
+        if (p < m_end && (*p == '-' || *p == '+'))
+            negative = *p++ == '-';
+
+        uint64_t mantissa = 0;
+        int significantDigits = 0;
+        int exponent = 0;
+        bool hasDigits = false;
+
+        for (; p < m_end && isDigit(*p); ++p)
+        {
+            hasDigits = true;
+            if (significantDigits < MAX_SIGNIFICANT_DIGITS)
+            {
+                mantissa = mantissa * 10 + uint64_t(*p - '0');
+                significantDigits += mantissa > 0 ? 1 : 0;
+            }
+            else
+                ++exponent;
+        }
+
+        if (p < m_end && *p == '.')
+        {
+            for (++p; p < m_end && isDigit(*p); ++p)
+            {
+                hasDigits = true;
+                if (significantDigits < MAX_SIGNIFICANT_DIGITS)
+                {
+                    mantissa = mantissa * 10 + uint64_t(*p - '0');
+                    significantDigits += mantissa > 0 ? 1 : 0;
+                    --exponent;
+                }
+            }
+        }
+
+        if (!hasDigits)
+            return false;
+
+        if (p < m_end && (*p == 'e' || *p == 'E'))
+        {
+            const char* e = p + 1;
+            bool negativeExponent = false;
+            if (e < m_end && (*e == '-' || *e == '+'))
+                negativeExponent = *e++ == '-';
+
+            // Without digits the 'e' isn't part of the number
+            if (e < m_end && isDigit(*e))
+            {
+                int explicitExponent = 0;
+                for (; e < m_end && isDigit(*e); ++e)
+                {
+                    if (explicitExponent < 10000)
+                        explicitExponent = explicitExponent * 10 + (*e - '0');
+                }
+
+                exponent += negativeExponent ? -explicitExponent : explicitExponent;
+                p = e;
+            }
+        }
+
+        double value = double(mantissa);
+        if (exponent != 0 && mantissa != 0)
+            value = exponent < 0 ? value / powerOf10(-exponent) : value * powerOf10(exponent);
+
+        out = float(negative ? -value : value);
+        m_cur = p;
+        return true;
+    }
+
+    /**
+    * Reads a signed decimal integer. Returns false if there is no number or it doesn't fit into int64_t.
+    */
+    bool readInt(int64_t& out)
+    {
+        skipSpaces();
+        const char* p = m_cur;
+
+        bool negative = false;
+        if (p < m_end && (*p == '-' || *p == '+'))
+            negative = *p++ == '-';
+
+        if (p >= m_end || !isDigit(*p))
+            return false;
+
+        int64_t value = 0;
+        for (; p < m_end && isDigit(*p); ++p)
+        {
+            int digit = *p - '0';
+            if (value > (std::numeric_limits<int64_t>::max() - digit) / 10)
+                return false;
+
+            value = value * 10 + digit;
+        }
+
+        out = negative ? -value : value;
+        m_cur = p;
+        return true;
+    }
+
+    /**
+    * Reads a face corner of the form v, v/vt, v//vn or v/vt/vn. Missing attributes are set to NO_INDEX.
+    * The indices are 1-based, negative indices are relative to the end of the list (see resolveIndex).
+    */
+    bool readFaceCorner(int64_t& outPosition, int64_t& outTexCoord, int64_t& outNormal)
+    {
+        outTexCoord = NO_INDEX;
+        outNormal = NO_INDEX;
+
+        if (!readInt(outPosition))
+            return false;
+
+        if (m_cur >= m_end || *m_cur != '/')
+            return true;
+
+        ++m_cur;
+        if (m_cur < m_end && *m_cur != '/' && !readAttributeIndex(outTexCoord))
+            return false;
+
+        if (m_cur >= m_end || *m_cur != '/')
+            return true;
+
+        ++m_cur;
+        return readAttributeIndex(outNormal);
+    }
+
+    /**
+    * Converts a 1-based or negative (relative) OBJ index into a 0-based index into a list with the given
+    * number of elements read so far. Returns false if the index is out of range.
+    */
+    static bool resolveIndex(int64_t objIndex, size_t count, uint32_t& outIndex)
+    {
+        int64_t index = objIndex < 0 ? int64_t(count) + objIndex : objIndex - 1;
+        if (index < 0 || index >= int64_t(count))
+            return false;
+
+        outIndex = uint32_t(index);
+        return true;
+    }
+
+private:
+    // A float needs at most 9 significant digits, more than 19 don't fit into the integer mantissa
+    static const int MAX_SIGNIFICANT_DIGITS = 19;
+
+    static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+    static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+    static double powerOf10(int exponent)
+    {
+        static const double POWERS[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                         1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+        return exponent < int(sizeof(POWERS) / sizeof(POWERS[0])) ? POWERS[exponent] : std::pow(10.0, double(exponent));
+    }
+
+    // Face corner attributes are unsigned in practice but relative indices are negative
+    bool readAttributeIndex(int64_t& outIndex)
+    {
+        if (m_cur >= m_end || !(isDigit(*m_cur) || *m_cur == '-' || *m_cur == '+'))
+            return false;
+
+        return readInt(outIndex);
+    }
+
+private:
+    const char* m_cur;
+    const char* m_end;
+};
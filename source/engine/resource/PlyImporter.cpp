@@ -0,0 +1,607 @@
+#include "PlyImporter.h"
+#include "ObjScanner.h"
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <engine/util/file.h>
+#include <engine/util/util.h>
+#include <engine/util/Logger.h>
+
+namespace
+{
+    enum class PlyFormat
+    {
+        Ascii,
+        BinaryLittleEndian,
+        BinaryBigEndian
+    };
+
+    enum class PlyType : uint8_t
+    {
+        Int8,
+        UInt8,
+        Int16,
+        UInt16,
+        Int32,
+        UInt32,
+        Float32,
+        Float64,
+        Invalid
+    };
+
+    // Vertex attribute that a property is decoded into
+    enum PlySlot
+    {
+        SLOT_NONE = -1,
+        SLOT_POSITION = 0,
+        SLOT_NORMAL = 3,
+        SLOT_UV = 6,
+        SLOT_COLOR = 8,
+        SLOT_COUNT = 11
+    };
+
+    struct PlyProperty
+    {
+        std::string name;
+        PlyType type{ PlyType::Invalid };
+        // Lists store the number of items with countType followed by the items with type
+        bool isList{ false };
+        PlyType countType{ PlyType::Invalid };
+
+        int slot{ SLOT_NONE };
+        // Integer colors are normalized with this factor
+        float scale{ 1.0f };
+    };
+
+    struct PlyElement
+    {
+        std::string name;
+        size_t count{ 0 };
+        std::vector<PlyProperty> properties;
+    };
+
+    struct PlyHeader
+    {
+        PlyFormat format{ PlyFormat::Ascii };
+        std::vector<PlyElement> elements;
+        // Start of the element data in the file
+        size_t dataOffset{ 0 };
+    };
+
+    PlyType parseType(const std::string& name)
+    {
+        if (name == "char" || name == "int8") return PlyType::Int8;
+        if (name == "uchar" || name == "uint8") return PlyType::UInt8;
+        if (name == "short" || name == "int16") return PlyType::Int16;
+        if (name == "ushort" || name == "uint16") return PlyType::UInt16;
+        if (name == "int" || name == "int32") return PlyType::Int32;
+        if (name == "uint" || name == "uint32") return PlyType::UInt32;
+        if (name == "float" || name == "float32") return PlyType::Float32;
+        if (name == "double" || name == "float64") return PlyType::Float64;
+        return PlyType::Invalid;
+    }
+
+    size_t typeSize(PlyType type)
+    {
+        switch (type)
+        {
+        case PlyType::Int8:
+        case PlyType::UInt8:
+            return 1;
+        case PlyType::Int16:
+        case PlyType::UInt16:
+            return 2;
+        case PlyType::Int32:
+        case PlyType::UInt32:
+        case PlyType::Float32:
+            return 4;
+        case PlyType::Float64:
+            return 8;
+        default:
+            return 0;
+        }
+    }
+
+    float integerColorScale(PlyType type)
+    {
+        switch (type)
+        {
+        case PlyType::UInt8: return 1.0f / 255.0f;
+        case PlyType::UInt16: return 1.0f / 65535.0f;
+        case PlyType::Int8: return 1.0f / 127.0f;
+        case PlyType::Int16: return 1.0f / 32767.0f;
+        default: return 1.0f;
+        }
+    }
+
+    int vertexSlot(const std::string& name)
+    {
+        static const char* const NAMES[][SLOT_COUNT] = {
+            { "x", "y", "z", "nx", "ny", "nz", "u", "v", "red", "green", "blue" },
+            { nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, "s", "t", "r", "g", "b" },
+            { nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, "texture_u", "texture_v", "diffuse_red", "diffuse_green", "diffuse_blue" }
+        };
+
+        for (auto& names : NAMES)
+        {
+            for (int slot = 0; slot < SLOT_COUNT; ++slot)
+            {
+                if (names[slot] && name == names[slot])
+                    return slot;
+            }
+        }
+
+        return SLOT_NONE;
+    }
+
+    bool parseHeader(const char* data, size_t size, PlyHeader& outHeader)
+    {
+        const char* cur = data;
+        const char* end = data + size;
+        bool first = true;
+
+        while (cur < end)
+        {
+            auto lineEnd = static_cast<const char*>(std::memchr(cur, '\n', size_t(end - cur)));
+            if (!lineEnd)
+                return false;
+
+            auto tokens = util::splitWhitespace(std::string(cur, lineEnd));
+            cur = lineEnd + 1;
+
+            if (first)
+            {
+                if (tokens.size() != 1 || tokens[0] != "ply")
+                    return false;
+
+                first = false;
+                continue;
+            }
+
+            if (tokens.empty() || tokens[0] == "comment" || tokens[0] == "obj_info")
+                continue;
+
+            if (tokens[0] == "end_header")
+            {
+                outHeader.dataOffset = size_t(cur - data);
+                return true;
+            }
+
+            if (tokens[0] == "format" && tokens.size() >= 2)
+            {
+                if (tokens[1] == "ascii")
+                    outHeader.format = PlyFormat::Ascii;
+                else if (tokens[1] == "binary_little_endian")
+                    outHeader.format = PlyFormat::BinaryLittleEndian;
+                else if (tokens[1] == "binary_big_endian")
+                    outHeader.format = PlyFormat::BinaryBigEndian;
+                else
+                    return false;
+            }
+            else if (tokens[0] == "element" && tokens.size() == 3)
+            {
+                PlyElement element;
+                element.name = tokens[1];
+                char* countEnd;
+                element.count = size_t(std::strtoull(tokens[2].c_str(), &countEnd, 10));
+                if (*countEnd != '\0')
+                    return false;
+
+                outHeader.elements.push_back(element);
+            }
+            else if (tokens[0] == "property" && !outHeader.elements.empty())
+            {
+                PlyProperty property;
+                if (tokens.size() == 5 && tokens[1] == "list")
+                {
+                    property.isList = true;
+                    property.countType = parseType(tokens[2]);
+                    property.type = parseType(tokens[3]);
+                    property.name = tokens[4];
+
+                    if (property.countType == PlyType::Invalid || property.countType == PlyType::Float32 || property.countType == PlyType::Float64)
+                        return false;
+                }
+                else if (tokens.size() == 3)
+                {
+                    property.type = parseType(tokens[1]);
+                    property.name = tokens[2];
+                }
+
+                if (property.type == PlyType::Invalid)
+                    return false;
+
+                outHeader.elements.back().properties.push_back(property);
+            }
+            else
+                return false;
+        }
+
+        return false;
+    }
+
+    // Lower bound of the size of a record in the file: the scalars and list counts of a binary record,
+    // a digit and a separator per property of an ASCII record
+    size_t minRecordSize(const PlyElement& element, PlyFormat format)
+    {
+        if (format == PlyFormat::Ascii)
+            return std::max(2 * element.properties.size(), size_t(1));
+
+        size_t size = 0;
+        for (auto& property : element.properties)
+            size += typeSize(property.isList ? property.countType : property.type);
+
+        return std::max(size, size_t(1));
+    }
+
+    // The counts come from the header, so they are checked against the size of the data before anything is allocated.
+    bool validateElements(const PlyHeader& header, size_t dataSize)
+    {
+        // The last value of an ASCII file doesn't need a separator
+        if (header.format == PlyFormat::Ascii)
+            ++dataSize;
+
+        size_t vertexElementCount = 0;
+        for (auto& element : header.elements)
+        {
+            size_t recordSize = minRecordSize(element, header.format);
+            if (element.count > dataSize / recordSize)
+                return false;
+
+            dataSize -= element.count * recordSize;
+            if (element.name == "vertex")
+                ++vertexElementCount;
+        }
+
+        return vertexElementCount <= 1;
+    }
+
+    bool isHostLittleEndian()
+    {
+        uint16_t value = 1;
+        uint8_t firstByte;
+        std::memcpy(&firstByte, &value, 1);
+        return firstByte == 1;
+    }
+
+    /**
+    * Reads binary values of either byte order with bounds checks.
+    */
+    class PlyBinaryReader
+    {
+    public:
+        PlyBinaryReader(const char* begin, const char* end, bool swapBytes)
+            :m_cur(begin), m_end(end), m_swapBytes(swapBytes) {}
+
+        bool readValue(PlyType type, double& out)
+        {
+            size_t size = typeSize(type);
+            if (size_t(m_end - m_cur) < size)
+                return false;
+
+            uint8_t bytes[8];
+            std::memcpy(bytes, m_cur, size);
+            m_cur += size;
+
+            if (m_swapBytes)
+                std::reverse(bytes, bytes + size);
+
+            switch (type)
+            {
+            case PlyType::Int8: { int8_t v; std::memcpy(&v, bytes, 1); out = v; break; }
+            case PlyType::UInt8: { out = bytes[0]; break; }
+            case PlyType::Int16: { int16_t v; std::memcpy(&v, bytes, 2); out = v; break; }
+            case PlyType::UInt16: { uint16_t v; std::memcpy(&v, bytes, 2); out = v; break; }
+            case PlyType::Int32: { int32_t v; std::memcpy(&v, bytes, 4); out = v; break; }
+            case PlyType::UInt32: { uint32_t v; std::memcpy(&v, bytes, 4); out = v; break; }
+            case PlyType::Float32: { float v; std::memcpy(&v, bytes, 4); out = v; break; }
+            case PlyType::Float64: { std::memcpy(&out, bytes, 8); break; }
+            default: return false;
+            }
+
+            return true;
+        }
+
+        bool readIndex(PlyType type, int64_t& out)
+        {
+            double value;
+            if (!readValue(type, value))
+                return false;
+
+            out = int64_t(value);
+            return true;
+        }
+
+        bool skip(PlyType type, size_t count)
+        {
+            size_t size = typeSize(type) * count;
+            if (size_t(m_end - m_cur) < size)
+                return false;
+
+            m_cur += size;
+            return true;
+        }
+
+        void endElement() {}
+
+    private:
+        const char* m_cur;
+        const char* m_end;
+        bool m_swapBytes;
+    };
+
+    /**
+    * Reads whitespace separated values - every element is on its own line.
+    */
+    class PlyAsciiReader
+    {
+    public:
+        PlyAsciiReader(const char* begin, const char* end)
+            :m_scanner(begin, end) {}
+
+        bool readValue(PlyType type, double& out)
+        {
+            float value;
+            if (!m_scanner.readFloat(value))
+                return false;
+
+            out = value;
+            return true;
+        }
+
+        bool readIndex(PlyType type, int64_t& out) { return m_scanner.readInt(out); }
+
+        bool skip(PlyType type, size_t count)
+        {
+            double value;
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (!readValue(type, value))
+                    return false;
+            }
+
+            return true;
+        }
+
+        void endElement() { m_scanner.skipLine(); }
+
+    private:
+        ObjScanner m_scanner;
+    };
+
+    struct PlyOutput
+    {
+        Mesh::SubMesh* subMesh{ nullptr };
+        bool hasSlot[SLOT_COUNT] = {};
+        size_t malformedFaceCount{ 0 };
+    };
+
+    template<class TReader>
+    bool skipProperty(const PlyProperty& property, TReader& reader)
+    {
+        if (!property.isList)
+            return reader.skip(property.type, 1);
+
+        int64_t count;
+        return reader.readIndex(property.countType, count) && count >= 0 && reader.skip(property.type, size_t(count));
+    }
+
+    template<class TReader>
+    bool readVertices(const PlyElement& element, TReader& reader, PlyOutput& output)
+    {
+        auto& subMesh = *output.subMesh;
+        float values[SLOT_COUNT] = {};
+
+        for (size_t i = 0; i < element.count; ++i)
+        {
+            for (auto& property : element.properties)
+            {
+                if (property.slot == SLOT_NONE || property.isList)
+                {
+                    if (!skipProperty(property, reader))
+                        return false;
+
+                    continue;
+                }
+
+                double value;
+                if (!reader.readValue(property.type, value))
+                    return false;
+
+                values[property.slot] = float(value) * property.scale;
+            }
+
+            reader.endElement();
+
+            subMesh.vertices[i] = glm::vec3(values[SLOT_POSITION], values[SLOT_POSITION + 1], values[SLOT_POSITION + 2]);
+            if (!subMesh.normals.empty())
+                subMesh.normals[i] = glm::vec3(values[SLOT_NORMAL], values[SLOT_NORMAL + 1], values[SLOT_NORMAL + 2]);
+            if (!subMesh.uvs.empty())
+                subMesh.uvs[i] = glm::vec2(values[SLOT_UV], values[SLOT_UV + 1]);
+            if (!subMesh.colors.empty())
+                subMesh.colors[i] = glm::vec3(values[SLOT_COLOR], values[SLOT_COLOR + 1], values[SLOT_COLOR + 2]);
+        }
+
+        return true;
+    }
+
+    template<class TReader>
+    bool readFaces(const PlyElement& element, TReader& reader, PlyOutput& output)
+    {
+        auto& indices = output.subMesh->indices;
+        size_t vertexCount = output.subMesh->vertices.size();
+
+        for (size_t i = 0; i < element.count; ++i)
+        {
+            for (auto& property : element.properties)
+            {
+                if (!property.isList || (property.name != "vertex_indices" && property.name != "vertex_index"))
+                {
+                    if (!skipProperty(property, reader))
+                        return false;
+
+                    continue;
+                }
+
+                int64_t count;
+                if (!reader.readIndex(property.countType, count) || count < 0)
+                    return false;
+
+                // Indices are appended as a triangle fan and dropped again if the face is malformed
+                size_t faceStart = indices.size();
+                int64_t first = 0;
+                int64_t prev = 0;
+                bool valid = count >= 3;
+
+                for (int64_t c = 0; c < count; ++c)
+                {
+                    int64_t index;
+                    if (!reader.readIndex(property.type, index))
+                        return false;
+
+                    valid = valid && index >= 0 && size_t(index) < vertexCount;
+                    if (c == 0)
+                        first = index;
+                    else if (c >= 2 && valid)
+                    {
+                        indices.push_back(IndexType(first));
+                        indices.push_back(IndexType(prev));
+                        indices.push_back(IndexType(index));
+                    }
+
+                    prev = index;
+                }
+
+                if (!valid)
+                {
+                    indices.resize(faceStart);
+                    ++output.malformedFaceCount;
+                }
+            }
+
+            reader.endElement();
+        }
+
+        return true;
+    }
+
+    template<class TReader>
+    bool skipElement(const PlyElement& element, TReader& reader)
+    {
+        for (size_t i = 0; i < element.count; ++i)
+        {
+            for (auto& property : element.properties)
+            {
+                if (!skipProperty(property, reader))
+                    return false;
+            }
+
+            reader.endElement();
+        }
+
+        return true;
+    }
+
+    template<class TReader>
+    bool readElements(const PlyHeader& header, TReader& reader, PlyOutput& output)
+    {
+        for (auto& element : header.elements)
+        {
+            bool success;
+            if (element.name == "vertex")
+                success = readVertices(element, reader, output);
+            else if (element.name == "face")
+                success = readFaces(element, reader, output);
+            else
+                success = skipElement(element, reader);
+
+            if (!success)
+                return false;
+        }
+
+        return true;
+    }
+}
+
+std::shared_ptr<Model> PlyImporter::import(const std::string& filename)
+{
+    std::shared_ptr<Model> model = std::make_shared<Model>();
+    model->subMeshes.resize(1);
+    auto& subMesh = model->subMeshes[0];
+
+    file::MappedFile mappedFile;
+    if (!mappedFile.open(filename))
+    {
+        Logger::stream() << "Could not open file: " << filename << std::endl;
+        return model;
+    }
+
+    PlyHeader header;
+    if (!parseHeader(mappedFile.data(), mappedFile.size(), header))
+    {
+        Logger::stream() << "Invalid PLY header: " << filename << std::endl;
+        return model;
+    }
+
+    if (!validateElements(header, mappedFile.size() - header.dataOffset))
+    {
+        Logger::stream() << "Truncated or corrupt PLY file: " << filename << std::endl;
+        return model;
+    }
+
+    PlyOutput output;
+    output.subMesh = &subMesh;
+
+    // The vertex attributes are known from the header, so the arrays are allocated once and filled in place.
+    // Faces can only be preallocated for triangles.
+    for (auto& element : header.elements)
+    {
+        if (element.name == "vertex")
+        {
+            for (auto& property : element.properties)
+            {
+                property.slot = property.isList ? SLOT_NONE : vertexSlot(property.name);
+                if (property.slot == SLOT_NONE)
+                    continue;
+
+                output.hasSlot[property.slot] = true;
+                if (property.slot >= SLOT_COLOR)
+                    property.scale = integerColorScale(property.type);
+            }
+
+            subMesh.vertices.resize(element.count);
+            if (output.hasSlot[SLOT_NORMAL])
+                subMesh.normals.resize(element.count);
+            if (output.hasSlot[SLOT_UV])
+                subMesh.uvs.resize(element.count);
+            if (output.hasSlot[SLOT_COLOR])
+                subMesh.colors.resize(element.count);
+        }
+        else if (element.name == "face")
+            subMesh.indices.reserve(element.count * 3);
+    }
+
+    const char* data = mappedFile.data() + header.dataOffset;
+    const char* end = mappedFile.data() + mappedFile.size();
+    bool success;
+
+    if (header.format == PlyFormat::Ascii)
+    {
+        PlyAsciiReader reader(data, end);
+        success = readElements(header, reader, output);
+    }
+    else
+    {
+        bool fileLittleEndian = header.format == PlyFormat::BinaryLittleEndian;
+        PlyBinaryReader reader(data, end, fileLittleEndian != isHostLittleEndian());
+        success = readElements(header, reader, output);
+    }
+
+    if (!success)
+        Logger::stream() << "Truncated or corrupt PLY file: " << filename << std::endl;
+
+    if (output.malformedFaceCount > 0)
+        Logger::stream() << "Skipped " << output.malformedFaceCount << " malformed faces in " << filename << std::endl;
+
+    return model;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <memory>
+#include <string>
+#include "Model.h"
+
+/**
+* Imports ASCII and binary (little and big endian) PLY files from a memory mapping.
+* The elements are decoded straight into a single sub mesh:
+* - vertex: x, y, z, optionally nx, ny, nz, texture coordinates (u, v / s, t / texture_u, texture_v)
+*   and colors (red, green, blue) of any scalar type - integer colors are normalized to [0, 1]
+* - face: the vertex_indices (or vertex_index) list, polygons are fan triangulated
+* Other properties and elements are skipped.
+*/
+class PlyImporter
+{
+public:
+    static std::shared_ptr<Model> import(const std::string& filename);
+};
@@ -0,0 +1,162 @@
+#include "StlImporter.h"
+#include "StlReader.h"
+#include <unordered_map>
+#include <cstring>
+#include <cmath>
+#include <engine/util/file.h>
+#include <engine/util/Logger.h>
+
+namespace
+{
+    const uint32_t NO_VERTEX = 0xFFFFFFFF;
+
+    /**
+    * Welds positions into vertices of a sub mesh. Every grid cell stores a chain of its vertices.
+    */
+    class VertexWelder
+    {
+    public:
+        VertexWelder(Vertices& vertices, float tolerance, size_t expectedVertexCount)
+            :m_vertices(vertices), m_tolerance(tolerance), m_toleranceSq(tolerance * tolerance)
+        {
+            m_cells.reserve(expectedVertexCount);
+            m_nextInCell.reserve(expectedVertexCount);
+            m_vertices.reserve(expectedVertexCount);
+        }
+
+        uint32_t weld(const glm::vec3& p)
+        {
+            if (m_tolerance <= 0.0f || !std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z))
+                return weldExact(p);
+
+            // Welded positions are at most one cell apart
+            glm::vec3 cellPos = glm::floor(p / m_tolerance);
+            int64_t cx = int64_t(cellPos.x), cy = int64_t(cellPos.y), cz = int64_t(cellPos.z);
+
+            for (int64_t x = cx - 1; x <= cx + 1; ++x)
+            {
+                for (int64_t y = cy - 1; y <= cy + 1; ++y)
+                {
+                    for (int64_t z = cz - 1; z <= cz + 1; ++z)
+                    {
+                        auto it = m_cells.find(cellKey(x, y, z));
+                        if (it == m_cells.end())
+                            continue;
+
+                        for (uint32_t v = it->second; v != NO_VERTEX; v = m_nextInCell[v])
+                        {
+                            glm::vec3 d = m_vertices[v] - p;
+                            if (glm::dot(d, d) <= m_toleranceSq)
+                                return v;
+                        }
+                    }
+                }
+            }
+
+            return addVertex(p, cellKey(cx, cy, cz));
+        }
+
+    private:
+        uint32_t weldExact(const glm::vec3& p)
+        {
+            uint32_t bits[3];
+            std::memcpy(bits, &p, sizeof(bits));
+            // -0 and 0 are equal positions with different bits
+            for (auto& b : bits)
+                b = b == 0x80000000u ? 0u : b;
+
+            uint64_t key = (uint64_t(bits[0]) * 0x9E3779B97F4A7C15ull) ^ (uint64_t(bits[1]) * 0xC2B2AE3D27D4EB4Full) ^ uint64_t(bits[2]);
+            auto it = m_cells.find(key);
+            if (it != m_cells.end())
+            {
+                for (uint32_t v = it->second; v != NO_VERTEX; v = m_nextInCell[v])
+                {
+                    if (m_vertices[v] == p)
+                        return v;
+                }
+            }
+
+            return addVertex(p, key);
+        }
+
+        uint32_t addVertex(const glm::vec3& p, uint64_t key)
+        {
+            uint32_t v = uint32_t(m_vertices.size());
+            m_vertices.push_back(p);
+
+            // Prepend to the chain of the cell - collisions of different cells in the key only lengthen the chain
+            auto result = m_cells.insert(std::make_pair(key, v));
+            m_nextInCell.push_back(result.second ? NO_VERTEX : result.first->second);
+            result.first->second = v;
+
+            return v;
+        }
+
+        static uint64_t cellKey(int64_t x, int64_t y, int64_t z)
+        {
+            return (uint64_t(x) & 0x1FFFFF) | ((uint64_t(y) & 0x1FFFFF) << 21) | ((uint64_t(z) & 0x1FFFFF) << 42);
+        }
+
+    private:
+        Vertices& m_vertices;
+        float m_tolerance;
+        float m_toleranceSq;
+
+        // First vertex of every cell and the next vertex in the cell of every vertex
+        std::unordered_map<uint64_t, uint32_t> m_cells;
+        std::vector<uint32_t> m_nextInCell;
+    };
+}
+
+std::shared_ptr<Model> StlImporter::import(const std::string& filename, float weldTolerance)
+{
+    std::shared_ptr<Model> model = std::make_shared<Model>();
+    model->subMeshes.resize(1);
+    auto& subMesh = model->subMeshes[0];
+
+    file::MappedFile mappedFile;
+    if (!mappedFile.open(filename))
+    {
+        Logger::stream() << "Could not open file: " << filename << std::endl;
+        return model;
+    }
+
+    uint32_t triangleCount = 0;
+    if (!StlReader::readTriangleCount(mappedFile.data(), mappedFile.size(), triangleCount))
+    {
+        Logger::stream() << "Not a binary STL file: " << filename << std::endl;
+        return model;
+    }
+
+    // Closed meshes have about half as many vertices as triangles
+    VertexWelder welder(subMesh.vertices, weldTolerance, triangleCount / 2 + 3);
+    subMesh.indices.reserve(size_t(triangleCount) * 3);
+
+    const char* data = StlReader::getTriangles(mappedFile.data());
+    size_t degenerateCount = 0;
+
+    for (uint32_t i = 0; i < triangleCount; ++i, data += StlReader::TRIANGLE_SIZE)
+    {
+        glm::vec3 corners[3];
+        StlReader::readCorners(data, corners);
+
+        uint32_t v0 = welder.weld(corners[0]);
+        uint32_t v1 = welder.weld(corners[1]);
+        uint32_t v2 = welder.weld(corners[2]);
+
+        if (v0 == v1 || v1 == v2 || v2 == v0)
+        {
+            ++degenerateCount;
+            continue;
+        }
+
+        subMesh.indices.push_back(v0);
+        subMesh.indices.push_back(v1);
+        subMesh.indices.push_back(v2);
+    }
+
+    if (degenerateCount > 0)
+        Logger::stream() << "Dropped " << degenerateCount << " degenerate triangles in " << filename << std::endl;
+
+    return model;
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <memory>
+#include <string>
+#include "Model.h"
+
+/**
+* Imports binary STL files. STL stores every triangle with its own corners, so coincident corners are welded
+* into shared vertices while the triangles are read - the result has the connectivity that DirectedEdgeMesh needs.
+* Corners closer than weldTolerance are welded with a spatial hash grid of that cell size,
+* a tolerance of 0 only welds bitwise equal positions. Triangles that degenerate by welding are dropped.
+*/
+class StlImporter
+{
+public:
+    static std::shared_ptr<Model> import(const std::string& filename, float weldTolerance = 0.0f);
+};
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <glm/glm.hpp>
+
+/**
+* Record layout of binary STL files, shared by StlImporter and TriangleStream:
+* 80 byte header | uint32 triangleCount | triangleCount * (vec3 normal, vec3 corners[3], uint16 attributeByteCount)
+*/
+class StlReader
+{
+public:
+    static const size_t HEADER_SIZE = 80;
+    // Normal, 3 corners and the attribute byte count
+    static const size_t TRIANGLE_SIZE = 12 * sizeof(float) + sizeof(uint16_t);
+
+    /**
+    * Reads the triangle count of the file data. Returns false if it isn't a binary STL file:
+    * ASCII files start with "solid" as well, so only the size identifies a binary file.
+    */
+    static bool readTriangleCount(const char* data, size_t size, uint32_t& outTriangleCount)
+    {
+        outTriangleCount = 0;
+        if (size < HEADER_SIZE + sizeof(uint32_t))
+            return false;
+
+        std::memcpy(&outTriangleCount, data + HEADER_SIZE, sizeof(uint32_t));
+        return size == HEADER_SIZE + sizeof(uint32_t) + uint64_t(outTriangleCount) * TRIANGLE_SIZE;
+    }
+
+    /**
+    * First triangle record of the file data.
+    */
+    static const char* getTriangles(const char* data) { return data + HEADER_SIZE + sizeof(uint32_t); }
+
+    /**
+    * Reads the 3 corners of a triangle record (unaligned).
+    */
+    static void readCorners(const char* triangle, glm::vec3* outCorners)
+    {
+        float corners[9];
+        std::memcpy(corners, triangle + 3 * sizeof(float), sizeof(corners));
+
+        for (int i = 0; i < 3; ++i)
+            outCorners[i] = glm::vec3(corners[3 * i], corners[3 * i + 1], corners[3 * i + 2]);
+    }
+};
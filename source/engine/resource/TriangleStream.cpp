@@ -0,0 +1,190 @@
+#include "TriangleStream.h"
+#include "ObjScanner.h"
+#include "StlReader.h"
+#include <cmath>
+#include <engine/util/Logger.h>
+
+namespace
+{
+    bool isFinite(const glm::vec3& p)
+    {
+        return std::isfinite(p.x) && std::isfinite(p.y) && std::isfinite(p.z);
+    }
+}
+
+bool TriangleStream::open(const std::string& filename)
+{
+    m_filename = filename;
+    m_format = Format::None;
+    m_mappedFile.close();
+    m_positions.clear();
+    m_positions.shrink_to_fit();
+
+    if (!m_mappedFile.open(filename))
+    {
+        Logger::stream() << "Could not open file: " << filename << std::endl;
+        return false;
+    }
+
+    const char* data = m_mappedFile.data();
+    m_end = data + m_mappedFile.size();
+
+    if (filename.find(".stl") != filename.npos)
+    {
+        uint32_t triangleCount = 0;
+        if (!StlReader::readTriangleCount(data, m_mappedFile.size(), triangleCount))
+        {
+            Logger::stream() << "Not a binary STL file: " << filename << std::endl;
+            return false;
+        }
+
+        m_format = Format::Stl;
+        m_dataBegin = StlReader::getTriangles(data);
+    }
+    else if (filename.find(".obj") != filename.npos)
+    {
+        // Faces may use absolute indices of positions that follow them, so all positions are read first.
+        // Malformed v records keep their number and are set to zero.
+        ObjScanner scanner(data, m_end);
+        while (!scanner.atEnd())
+        {
+            if (scanner.readRecordType() == ObjRecordType::Position)
+            {
+                glm::vec3 p;
+                bool valid = scanner.readFloat(p.x) && scanner.readFloat(p.y) && scanner.readFloat(p.z);
+                m_positions.push_back(valid ? p : glm::vec3(0.0f));
+            }
+
+            scanner.skipLine();
+        }
+
+        m_format = Format::Obj;
+        m_dataBegin = data;
+    }
+    else
+    {
+        Logger::stream() << "Unsupported file format for streaming: " << filename << std::endl;
+        return false;
+    }
+
+    rewind();
+    return true;
+}
+
+void TriangleStream::rewind()
+{
+    m_cur = m_dataBegin;
+    m_malformedFaceCount = 0;
+    m_curPositionCount = 0;
+    m_faceCorners.clear();
+    m_nextFanTriangle = 0;
+}
+
+size_t TriangleStream::read(glm::vec3* outCorners, size_t maxTriangles)
+{
+    switch (m_format)
+    {
+    case Format::Stl:
+        return readStl(outCorners, maxTriangles);
+    case Format::Obj:
+        return readObj(outCorners, maxTriangles);
+    default:
+        return 0;
+    }
+}
+
+size_t TriangleStream::readStl(glm::vec3* outCorners, size_t maxTriangles)
+{
+    size_t count = 0;
+    for (; count < maxTriangles && m_cur < m_end; m_cur += StlReader::TRIANGLE_SIZE)
+    {
+        glm::vec3* triangle = outCorners + 3 * count;
+        StlReader::readCorners(m_cur, triangle);
+
+        if (!isFinite(triangle[0]) || !isFinite(triangle[1]) || !isFinite(triangle[2]))
+        {
+            ++m_malformedFaceCount;
+            continue;
+        }
+
+        ++count;
+    }
+
+    return count;
+}
+
+size_t TriangleStream::readObj(glm::vec3* outCorners, size_t maxTriangles)
+{
+    size_t count = 0;
+    while (count < maxTriangles)
+    {
+        // Continue the fan of the current face, it may span several batches
+        if (m_nextFanTriangle + 2 < m_faceCorners.size())
+        {
+            size_t i = m_nextFanTriangle + 2;
+            glm::vec3* triangle = outCorners + 3 * count;
+            triangle[0] = m_positions[m_faceCorners[0]];
+            triangle[1] = m_positions[m_faceCorners[i - 1]];
+            triangle[2] = m_positions[m_faceCorners[i]];
+
+            ++m_nextFanTriangle;
+            if (isFinite(triangle[0]) && isFinite(triangle[1]) && isFinite(triangle[2]))
+                ++count;
+            else
+                ++m_malformedFaceCount;
+
+            continue;
+        }
+
+        if (m_cur >= m_end)
+            break;
+
+        ObjScanner scanner(m_cur, m_end);
+        switch (scanner.readRecordType())
+        {
+        case ObjRecordType::Position:
+            ++m_curPositionCount;
+            break;
+        case ObjRecordType::Face:
+            if (!readObjFace(scanner))
+                ++m_malformedFaceCount;
+            break;
+        default:
+            break;
+        }
+
+        scanner.skipLine();
+        m_cur = scanner.position();
+    }
+
+    return count;
+}
+
+bool TriangleStream::readObjFace(ObjScanner& scanner)
+{
+    m_faceCorners.clear();
+    m_nextFanTriangle = 0;
+
+    while (!scanner.atLineEnd())
+    {
+        int64_t position, texCoord, normal;
+        uint32_t index;
+        // Relative indices refer to the positions read so far, absolute indices to all positions of the file
+        if (!scanner.readFaceCorner(position, texCoord, normal) ||
+            !ObjScanner::resolveIndex(position, position < 0 ? m_curPositionCount : m_positions.size(), index))
+        {
+            m_faceCorners.clear();
+            return false;
+        }
+
+        m_faceCorners.push_back(index);
+    }
+
+    if (m_faceCorners.size() < 3)
+    {
+        m_faceCorners.clear();
+        return false;
+    }
+
+    return true;
+}
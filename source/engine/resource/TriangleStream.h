@@ -0,0 +1,76 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <engine/util/file.h>
+
+class ObjScanner;
+
+/**
+* Reads the triangles of a mesh file sequentially in batches without building the mesh,
+* so files larger than the memory can be processed (see StreamingSimplifier).
+* The file is memory mapped, the OS loads and evicts its pages while the stream moves through it.
+* - binary STL: the triangles are read straight from the mapping
+* - OBJ: the positions are kept in memory (12 bytes per vertex), the faces are read from the mapping and fan triangulated
+* Triangles with non-finite corners are skipped.
+*/
+class TriangleStream
+{
+public:
+    TriangleStream() {}
+
+    TriangleStream(const TriangleStream&) = delete;
+    TriangleStream& operator=(const TriangleStream&) = delete;
+
+    /**
+    * Chooses the format by the file extension (.stl or .obj). Returns false if the file can't be read.
+    */
+    bool open(const std::string& filename);
+
+    /**
+    * Writes the corners of up to maxTriangles triangles to outCorners (3 * maxTriangles elements).
+    * Returns the number of triangles written, 0 at the end of the file.
+    */
+    size_t read(glm::vec3* outCorners, size_t maxTriangles);
+
+    /**
+    * Starts reading from the first triangle again.
+    */
+    void rewind();
+
+    const std::string& getFilename() const { return m_filename; }
+
+    // Faces that are skipped because of invalid indices and triangles with non-finite corners, counted while reading
+    size_t getMalformedFaceCount() const { return m_malformedFaceCount; }
+
+private:
+    enum class Format
+    {
+        None,
+        Stl,
+        Obj
+    };
+
+    size_t readStl(glm::vec3* outCorners, size_t maxTriangles);
+    size_t readObj(glm::vec3* outCorners, size_t maxTriangles);
+
+    // Reads the corners of a face record into m_faceCorners. Returns false if the face is malformed.
+    bool readObjFace(ObjScanner& scanner);
+
+private:
+    std::string m_filename;
+    Format m_format{ Format::None };
+    file::MappedFile m_mappedFile;
+
+    const char* m_dataBegin{ nullptr };
+    const char* m_cur{ nullptr };
+    const char* m_end{ nullptr };
+    size_t m_malformedFaceCount{ 0 };
+
+    // OBJ: all positions of the file, the number of v records before the current line (for relative indices)
+    // and the face that is being triangulated
+    std::vector<glm::vec3> m_positions;
+    size_t m_curPositionCount{ 0 };
+    std::vector<uint32_t> m_faceCorners;
+    size_t m_nextFanTriangle{ 0 };
+};
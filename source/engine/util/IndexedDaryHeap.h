@@ -0,0 +1,224 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cassert>
+#include <limits>
+#include <algorithm>
+
+/**
+* Min-heap with an arity of D that additionally keeps track of the position of every element in the heap.
+* Every element is identified by a dense integer key (e.g. an EdgeID) which is extracted with TKeyOf.
+* The position table allows to update or remove elements in place in O(D * log_D(n)) without searching and
+* without any allocation once the heap reached its maximum size.
+* A higher arity results in a flatter tree with better cache locality - 4 is a good default.
+*/
+template<class T, class TCompare, class TKeyOf, size_t D = 4>
+class IndexedDaryHeap
+{
+    static_assert(D >= 2, "The arity of the heap must be at least 2.");
+public:
+    using Position = uint32_t;
+    static const Position INVALID_POSITION = std::numeric_limits<Position>::max();
+
+    IndexedDaryHeap() {}
+
+    /**
+    * Reserves memory for keys in [0, keyCount) - keys outside of this range are not allowed.
+    * Must be called before elements are added.
+    */
+    void resizeKeys(size_t keyCount);
+
+    /**
+    * Adds the element if its key is not in the heap, otherwise the stored element is replaced
+    * and moved to its correct position.
+    */
+    void update(const T& elem);
+
+    /**
+    * Replaces the content of the heap with the given elements and builds the heap in O(n).
+    * The keys of the elements must be unique.
+    */
+    void assign(std::vector<T> elems);
+
+    /**
+    * Removes the element with the given key. Returns false if there is no such element.
+    */
+    bool remove(size_t key);
+
+    const T& top() const { assert(!empty()); return m_heap[0]; }
+    T pop();
+
+    bool contains(size_t key) const { return key < m_positions.size() && m_positions[key] != INVALID_POSITION; }
+    size_t size() const { return m_heap.size(); }
+    bool empty() const { return m_heap.empty(); }
+    void clear();
+
+private:
+    void siftUp(Position pos);
+    void siftDown(Position pos);
+    void place(const T& elem, Position pos);
+
+private:
+    std::vector<T> m_heap;
+    // The index into the vector corresponds to the key of an element.
+    std::vector<Position> m_positions;
+    TCompare m_compare;
+    TKeyOf m_keyOf;
+};
+
+template<class T, class TCompare, class TKeyOf, size_t D>
+const typename IndexedDaryHeap<T, TCompare, TKeyOf, D>::Position IndexedDaryHeap<T, TCompare, TKeyOf, D>::INVALID_POSITION;
+
+template<class T, class TCompare, class TKeyOf, size_t D>
+void IndexedDaryHeap<T, TCompare, TKeyOf, D>::resizeKeys(size_t keyCount)
+{
+    m_positions.resize(keyCount, INVALID_POSITION);
+    m_heap.reserve(keyCount);
+}
+
+template<class T, class TCompare, class TKeyOf, size_t D>
+void IndexedDaryHeap<T, TCompare, TKeyOf, D>::update(const T& elem)
+{
+    size_t key = m_keyOf(elem);
+    assert(key < m_positions.size());
+
+    Position pos = m_positions[key];
+
+    if (pos == INVALID_POSITION)
+    {
+        m_heap.push_back(elem);
+        m_positions[key] = Position(m_heap.size() - 1);
+        siftUp(Position(m_heap.size() - 1));
+        return;
+    }
+
+    bool decreased = m_compare(elem, m_heap[pos]);
+    m_heap[pos] = elem;
+
+    if (decreased)
+        siftUp(pos);
+    else
+        siftDown(pos);
+}
+
+template<class T, class TCompare, class TKeyOf, size_t D>
+void IndexedDaryHeap<T, TCompare, TKeyOf, D>::assign(std::vector<T> elems)
+{
+    clear();
+    m_heap = std::move(elems);
+
+    for (size_t i = 0; i < m_heap.size(); ++i)
+    {
+        assert(m_keyOf(m_heap[i]) < m_positions.size() && m_positions[m_keyOf(m_heap[i])] == INVALID_POSITION);
+        m_positions[m_keyOf(m_heap[i])] = Position(i);
+    }
+
+    // Floyd's method: sift down all inner nodes starting with the last one
+    if (m_heap.size() > 1)
+    {
+        for (size_t i = (m_heap.size() - 2) / D + 1; i > 0; --i)
+            siftDown(Position(i - 1));
+    }
+}
+
+template<class T, class TCompare, class TKeyOf, size_t D>
+bool IndexedDaryHeap<T, TCompare, TKeyOf, D>::remove(size_t key)
+{
+    if (!contains(key))
+        return false;
+
+    Position pos = m_positions[key];
+    m_positions[key] = INVALID_POSITION;
+
+    Position lastPos = Position(m_heap.size() - 1);
+    if (pos != lastPos)
+    {
+        T last = m_heap[lastPos];
+        m_heap.pop_back();
+
+        bool decreased = m_compare(last, m_heap[pos]);
+        place(last, pos);
+
+        if (decreased)
+            siftUp(pos);
+        else
+            siftDown(pos);
+    }
+    else
+        m_heap.pop_back();
+
+    return true;
+}
+
+template<class T, class TCompare, class TKeyOf, size_t D>
+T IndexedDaryHeap<T, TCompare, TKeyOf, D>::pop()
+{
+    assert(!empty());
+
+    T minElem = m_heap[0];
+    remove(m_keyOf(minElem));
+    return minElem;
+}
+
+template<class T, class TCompare, class TKeyOf, size_t D>
+void IndexedDaryHeap<T, TCompare, TKeyOf, D>::clear()
+{
+    for (auto& elem : m_heap)
+        m_positions[m_keyOf(elem)] = INVALID_POSITION;
+
+    m_heap.clear();
+}
+
+template<class T, class TCompare, class TKeyOf, size_t D>
+void IndexedDaryHeap<T, TCompare, TKeyOf, D>::siftUp(Position pos)
+{
+    T elem = m_heap[pos];
+
+    while (pos > 0)
+    {
+        Position parent = (pos - 1) / D;
+        if (!m_compare(elem, m_heap[parent]))
+            break;
+
+        place(m_heap[parent], pos);
+        pos = parent;
+    }
+
+    place(elem, pos);
+}
+
+template<class T, class TCompare, class TKeyOf, size_t D>
+void IndexedDaryHeap<T, TCompare, TKeyOf, D>::siftDown(Position pos)
+{
+    T elem = m_heap[pos];
+    size_t count = m_heap.size();
+
+    while (true)
+    {
+        size_t firstChild = size_t(pos) * D + 1;
+        if (firstChild >= count)
+            break;
+
+        size_t lastChild = std::min(firstChild + D, count);
+        size_t minChild = firstChild;
+
+        for (size_t c = firstChild + 1; c < lastChild; ++c)
+            if (m_compare(m_heap[c], m_heap[minChild]))
+                minChild = c;
+
+        if (!m_compare(m_heap[minChild], elem))
+            break;
+
+        place(m_heap[minChild], pos);
+        pos = Position(minChild);
+    }
+
+    place(elem, pos);
+}
+
+template<class T, class TCompare, class TKeyOf, size_t D>
+void IndexedDaryHeap<T, TCompare, TKeyOf, D>::place(const T& elem, Position pos)
+{
+    m_heap[pos] = elem;
+    m_positions[m_keyOf(elem)] = pos;
+}
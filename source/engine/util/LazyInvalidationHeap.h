@@ -0,0 +1,210 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cassert>
+#include <algorithm>
+
+/**
+* Min-heap that never searches for an element: updating an element just pushes a new entry and
+* invalidates all older entries of the same key by incrementing a per key generation counter.
+* Stale entries stay in the flat binary heap and are discarded when they reach the top.
+* If the heap is filled mostly with stale entries it is compacted to keep the memory bounded.
+* Every element is identified by a dense integer key (e.g. an EdgeID) which is extracted with TKeyOf.
+*/
+template<class T, class TCompare, class TKeyOf>
+class LazyInvalidationHeap
+{
+    struct Entry
+    {
+        Entry() {}
+        Entry(const T& value, uint32_t generation)
+            :value(value), generation(generation) {}
+
+        T value;
+        uint32_t generation{ 0 };
+    };
+
+    // std heap functions build a max-heap -> invert the comparison
+    struct EntryCompare
+    {
+        bool operator()(const Entry& lhs, const Entry& rhs) const { return compare(rhs.value, lhs.value); }
+
+        TCompare compare;
+    };
+
+public:
+    LazyInvalidationHeap() {}
+
+    /**
+    * Reserves memory for keys in [0, keyCount) - keys outside of this range are not allowed.
+    * Must be called before elements are added.
+    */
+    void resizeKeys(size_t keyCount);
+
+    /**
+    * Adds the element. A previously added element with the same key becomes stale.
+    */
+    void update(const T& elem);
+
+    /**
+    * Replaces the content of the heap with the given elements and builds the heap in O(n).
+    * The keys of the elements must be unique.
+    */
+    void assign(const std::vector<T>& elems);
+
+    /**
+    * Removes the element with the given key in O(1). Returns false if there is no such element.
+    */
+    bool remove(size_t key);
+
+    /**
+    * Returns the minimum element. Stale entries at the top are discarded.
+    */
+    const T& top();
+    T pop();
+
+    bool contains(size_t key) const { return key < m_generations.size() && isLive(m_generations[key]); }
+    // Returns the number of live elements.
+    size_t size() const { return m_liveCount; }
+    bool empty() const { return m_liveCount == 0; }
+    // Returns the number of stored entries including stale ones.
+    size_t entryCount() const { return m_heap.size(); }
+    void clear();
+
+    /**
+    * Removes all stale entries and rebuilds the heap in O(n).
+    */
+    void compact();
+
+private:
+    // The generation of a key is odd iff the key has a live entry in the heap.
+    static bool isLive(uint32_t generation) { return (generation & 1) != 0; }
+    bool isStale(const Entry& entry) const { return entry.generation != m_generations[m_keyOf(entry.value)]; }
+    void discardStaleTop();
+
+private:
+    // Compaction is triggered if there are more stale entries than live ones (and at least this many entries).
+    static const size_t MIN_COMPACTION_SIZE = 1024;
+
+    std::vector<Entry> m_heap;
+    // The index into the vector corresponds to the key of an element.
+    std::vector<uint32_t> m_generations;
+    size_t m_liveCount{ 0 };
+    EntryCompare m_compare;
+    TKeyOf m_keyOf;
+};
+
+template<class T, class TCompare, class TKeyOf>
+const size_t LazyInvalidationHeap<T, TCompare, TKeyOf>::MIN_COMPACTION_SIZE;
+
+template<class T, class TCompare, class TKeyOf>
+void LazyInvalidationHeap<T, TCompare, TKeyOf>::resizeKeys(size_t keyCount)
+{
+    m_generations.resize(keyCount, 0);
+    m_heap.reserve(keyCount);
+}
+
+template<class T, class TCompare, class TKeyOf>
+void LazyInvalidationHeap<T, TCompare, TKeyOf>::update(const T& elem)
+{
+    size_t key = m_keyOf(elem);
+    assert(key < m_generations.size());
+
+    if (m_heap.size() >= MIN_COMPACTION_SIZE && m_heap.size() >= 2 * m_liveCount)
+        compact();
+
+    uint32_t& generation = m_generations[key];
+    if (isLive(generation))
+        generation += 2;
+    else
+    {
+        ++generation;
+        ++m_liveCount;
+    }
+
+    m_heap.push_back(Entry(elem, generation));
+    std::push_heap(m_heap.begin(), m_heap.end(), m_compare);
+}
+
+template<class T, class TCompare, class TKeyOf>
+void LazyInvalidationHeap<T, TCompare, TKeyOf>::assign(const std::vector<T>& elems)
+{
+    clear();
+
+    for (auto& elem : elems)
+    {
+        uint32_t& generation = m_generations[m_keyOf(elem)];
+        assert(!isLive(generation));
+
+        ++generation;
+        m_heap.push_back(Entry(elem, generation));
+    }
+
+    m_liveCount = m_heap.size();
+    std::make_heap(m_heap.begin(), m_heap.end(), m_compare);
+}
+
+template<class T, class TCompare, class TKeyOf>
+bool LazyInvalidationHeap<T, TCompare, TKeyOf>::remove(size_t key)
+{
+    if (!contains(key))
+        return false;
+
+    ++m_generations[key];
+    --m_liveCount;
+    return true;
+}
+
+template<class T, class TCompare, class TKeyOf>
+const T& LazyInvalidationHeap<T, TCompare, TKeyOf>::top()
+{
+    assert(!empty());
+    discardStaleTop();
+    return m_heap[0].value;
+}
+
+template<class T, class TCompare, class TKeyOf>
+T LazyInvalidationHeap<T, TCompare, TKeyOf>::pop()
+{
+    assert(!empty());
+    discardStaleTop();
+
+    T minElem = m_heap[0].value;
+    std::pop_heap(m_heap.begin(), m_heap.end(), m_compare);
+    m_heap.pop_back();
+
+    remove(m_keyOf(minElem));
+    return minElem;
+}
+
+template<class T, class TCompare, class TKeyOf>
+void LazyInvalidationHeap<T, TCompare, TKeyOf>::clear()
+{
+    for (auto& entry : m_heap)
+    {
+        uint32_t& generation = m_generations[m_keyOf(entry.value)];
+        if (isLive(generation))
+            ++generation;
+    }
+
+    m_heap.clear();
+    m_liveCount = 0;
+}
+
+template<class T, class TCompare, class TKeyOf>
+void LazyInvalidationHeap<T, TCompare, TKeyOf>::compact()
+{
+    m_heap.erase(std::remove_if(m_heap.begin(), m_heap.end(), [this](const Entry& e) { return isStale(e); }), m_heap.end());
+    assert(m_heap.size() == m_liveCount);
+    std::make_heap(m_heap.begin(), m_heap.end(), m_compare);
+}
+
+template<class T, class TCompare, class TKeyOf>
+void LazyInvalidationHeap<T, TCompare, TKeyOf>::discardStaleTop()
+{
+    while (isStale(m_heap[0]))
+    {
+        std::pop_heap(m_heap.begin(), m_heap.end(), m_compare);
+        m_heap.pop_back();
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <atomic>
+#include <utility>
+
+/**
+* Lock-free queue for any number of producer threads and a single consumer thread.
+* Producers push onto an atomic list head with compare and swap. The consumer takes the whole list
+* with one exchange and processes it in push order, so there is no ABA problem and consume() never waits.
+* Values pushed before a consume() call are visible to the consumer together with all writes
+* that the producer made before the push.
+*/
+template<class T>
+class MpscQueue
+{
+    struct Node
+    {
+        explicit Node(T&& value)
+            :value(std::move(value)) {}
+
+        T value;
+        Node* next{ nullptr };
+    };
+
+public:
+    MpscQueue() {}
+    ~MpscQueue();
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    /**
+    * Can be called concurrently from any thread.
+    */
+    void push(T value);
+
+    /**
+    * Calls func(value) for every value pushed so far in push order and removes them.
+    * Must only be called by one thread at a time. Returns the number of consumed values.
+    */
+    template<class TFunc>
+    size_t consume(TFunc func);
+
+    bool empty() const { return m_head.load(std::memory_order_acquire) == nullptr; }
+
+private:
+    // Most recently pushed node, the nodes are linked in reverse push order
+    std::atomic<Node*> m_head{ nullptr };
+};
+
+template<class T>
+MpscQueue<T>::~MpscQueue()
+{
+    consume([](T&) {});
+}
+
+template<class T>
+void MpscQueue<T>::push(T value)
+{
+    Node* node = new Node(std::move(value));
+    node->next = m_head.load(std::memory_order_relaxed);
+
+    while (!m_head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {}
+}
+
+template<class T>
+template<class TFunc>
+size_t MpscQueue<T>::consume(TFunc func)
+{
+    Node* node = m_head.exchange(nullptr, std::memory_order_acquire);
+
+    // Reverse the list to get the push order
+    Node* ordered = nullptr;
+    while (node)
+    {
+        Node* next = node->next;
+        node->next = ordered;
+        ordered = node;
+        node = next;
+    }
+
+    size_t count = 0;
+    while (ordered)
+    {
+        Node* next = ordered->next;
+        func(ordered->value);
+        delete ordered;
+        ordered = next;
+        ++count;
+    }
+
+    return count;
+}
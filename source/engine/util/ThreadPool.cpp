@@ -0,0 +1,136 @@
+#include "ThreadPool.h"
+
+#ifndef EMSCRIPTEN
+namespace
+{
+    // Set while the current thread executes tasks of a batch -> nested calls are executed serially
+    thread_local bool t_executingTasks = false;
+}
+#endif
+
+ThreadPool::ThreadPool(size_t threadCount)
+{
+#ifndef EMSCRIPTEN
+    if (threadCount == 0)
+        threadCount = std::max(size_t(std::thread::hardware_concurrency()), size_t(1));
+
+    m_threadCount = threadCount;
+
+    for (size_t i = 1; i < m_threadCount; ++i)
+        m_workers.push_back(std::thread([this]() { workerLoop(); }));
+#endif
+}
+
+ThreadPool::~ThreadPool()
+{
+#ifndef EMSCRIPTEN
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+
+    m_wakeUp.notify_all();
+
+    for (auto& worker : m_workers)
+        worker.join();
+#endif
+}
+
+ThreadPool& ThreadPool::getDefault()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+size_t ThreadPool::computeChunkCount(size_t count, size_t minChunkSize) const
+{
+    minChunkSize = std::max(minChunkSize, size_t(1));
+    return std::min(m_threadCount, (count + minChunkSize - 1) / minChunkSize);
+}
+
+void ThreadPool::run(size_t taskCount, const Task& task)
+{
+#ifndef EMSCRIPTEN
+    std::unique_lock<std::mutex> runLock(m_runMutex, std::defer_lock);
+
+    if (taskCount > 1 && !m_workers.empty() && !t_executingTasks && runLock.try_lock())
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            // A worker that woke up late for the previous batch might still check for tasks
+            m_done.wait(lock, [this]() { return m_activeWorkers == 0; });
+            m_task = &task;
+            m_taskCount = taskCount;
+            m_nextTask = 0;
+            m_finishedTasks = 0;
+            ++m_batch;
+        }
+
+        m_wakeUp.notify_all();
+        executeTasks();
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this]() { return m_finishedTasks == m_taskCount && m_activeWorkers == 0; });
+        m_task = nullptr;
+        return;
+    }
+#endif
+
+    for (size_t i = 0; i < taskCount; ++i)
+        task(i);
+}
+
+#ifndef EMSCRIPTEN
+void ThreadPool::workerLoop()
+{
+    size_t batch = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wakeUp.wait(lock, [this, batch]() { return m_stop || m_batch != batch; });
+
+            if (m_stop)
+                return;
+
+            batch = m_batch;
+            ++m_activeWorkers;
+        }
+
+        executeTasks();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_activeWorkers;
+        }
+
+        m_done.notify_all();
+    }
+}
+
+void ThreadPool::executeTasks()
+{
+    t_executingTasks = true;
+
+    size_t finishedTasks = 0;
+    size_t taskIdx;
+    while ((taskIdx = m_nextTask.fetch_add(1)) < m_taskCount)
+    {
+        (*m_task)(taskIdx);
+        ++finishedTasks;
+    }
+
+    t_executingTasks = false;
+
+    if (finishedTasks > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_finishedTasks += finishedTasks;
+        }
+
+        m_done.notify_all();
+    }
+}
+#endif
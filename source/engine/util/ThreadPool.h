@@ -0,0 +1,165 @@
+#pragma once
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <cstddef>
+
+#ifndef EMSCRIPTEN
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#endif
+
+/**
+* Fixed set of worker threads that execute a batch of tasks together with the calling thread.
+* Without thread support (emscripten) or if the pool is already busy (nested or concurrent calls)
+* the tasks are executed serially on the calling thread - callers don't need a separate code path.
+*/
+class ThreadPool
+{
+public:
+    using Task = std::function<void(size_t taskIdx)>;
+
+    /**
+    * threadCount includes the calling thread. 0 uses the number of hardware threads.
+    */
+    explicit ThreadPool(size_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+    * Shared pool that uses all hardware threads.
+    */
+    static ThreadPool& getDefault();
+
+    /**
+    * Number of threads that execute tasks including the calling thread.
+    */
+    size_t getThreadCount() const { return m_threadCount; }
+
+    /**
+    * Executes task(0), ..., task(taskCount - 1) and blocks until all tasks are finished.
+    */
+    void run(size_t taskCount, const Task& task);
+
+    /**
+    * Splits [0, count) into at most one chunk per thread (but at least minChunkSize elements per chunk)
+    * and calls func(begin, end) for every chunk. Returns the number of chunks - chunk i covers
+    * [i * count / chunkCount, (i + 1) * count / chunkCount).
+    */
+    template<class TFunc>
+    size_t parallelForChunks(size_t count, TFunc func, size_t minChunkSize = 1024);
+
+    /**
+    * Calls func(i) for every i in [0, count).
+    */
+    template<class TFunc>
+    void parallelFor(size_t count, TFunc func, size_t minChunkSize = 1024);
+
+    /**
+    * Sorts [begin, end) by sorting one chunk per thread and merging the chunks pairwise in parallel.
+    * TIterator must be a random access iterator.
+    */
+    template<class TIterator, class TCompare>
+    void sort(TIterator begin, TIterator end, TCompare compare, size_t minChunkSize = 1 << 14);
+
+    /**
+    * Returns the number of chunks parallelForChunks uses for the given count.
+    */
+    size_t computeChunkCount(size_t count, size_t minChunkSize = 1024) const;
+
+private:
+#ifndef EMSCRIPTEN
+    void workerLoop();
+    void executeTasks();
+#endif
+
+private:
+    size_t m_threadCount{ 1 };
+
+#ifndef EMSCRIPTEN
+    std::vector<std::thread> m_workers;
+    // Only one batch is executed at a time
+    std::mutex m_runMutex;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeUp;
+    std::condition_variable m_done;
+    // Incremented for every batch, workers sleep until it changes
+    size_t m_batch{ 0 };
+    bool m_stop{ false };
+
+    const Task* m_task{ nullptr };
+    size_t m_taskCount{ 0 };
+    std::atomic<size_t> m_nextTask{ 0 };
+    size_t m_finishedTasks{ 0 };
+    // Workers that joined the current batch - the batch state is only reset if no worker uses it
+    size_t m_activeWorkers{ 0 };
+#endif
+};
+
+template <class TFunc>
+size_t ThreadPool::parallelForChunks(size_t count, TFunc func, size_t minChunkSize)
+{
+    size_t chunkCount = computeChunkCount(count, minChunkSize);
+
+    if (chunkCount <= 1)
+    {
+        if (count > 0)
+            func(size_t(0), count);
+
+        return chunkCount;
+    }
+
+    run(chunkCount, [count, chunkCount, &func](size_t chunkIdx)
+    {
+        func(chunkIdx * count / chunkCount, (chunkIdx + 1) * count / chunkCount);
+    });
+
+    return chunkCount;
+}
+
+template <class TFunc>
+void ThreadPool::parallelFor(size_t count, TFunc func, size_t minChunkSize)
+{
+    parallelForChunks(count, [&func](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            func(i);
+    }, minChunkSize);
+}
+
+template <class TIterator, class TCompare>
+void ThreadPool::sort(TIterator begin, TIterator end, TCompare compare, size_t minChunkSize)
+{
+    size_t count = size_t(end - begin);
+    size_t chunkCount = computeChunkCount(count, minChunkSize);
+
+    if (chunkCount <= 1)
+    {
+        std::sort(begin, end, compare);
+        return;
+    }
+
+    auto chunkBegin = [begin, count, chunkCount](size_t chunkIdx) { return begin + std::min(chunkIdx, chunkCount) * count / chunkCount; };
+
+    run(chunkCount, [&chunkBegin, &compare](size_t chunkIdx)
+    {
+        std::sort(chunkBegin(chunkIdx), chunkBegin(chunkIdx + 1), compare);
+    });
+
+    // Merge neighboring runs of width chunks until a single sorted run is left
+    for (size_t width = 1; width < chunkCount; width *= 2)
+    {
+        size_t mergeCount = (chunkCount + 2 * width - 1) / (2 * width);
+
+        run(mergeCount, [&chunkBegin, &compare, width](size_t mergeIdx)
+        {
+            size_t first = mergeIdx * 2 * width;
+            std::inplace_merge(chunkBegin(first), chunkBegin(first + width), chunkBegin(first + 2 * width), compare);
+        });
+    }
+}
@@ -1,10 +1,25 @@
 #include "file.h"
 #include <fstream>
+#include <cstdio>
 #include "Logger.h"
 #include <vector>
 #include <sys/types.h>
 #include <sys/stat.h>
 
+#if defined(_WIN32) && !defined(EMSCRIPTEN)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif !defined(EMSCRIPTEN)
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 std::string file::readAsString(const std::string& path)
 {
     std::string fileAsString = "";
@@ -43,3 +58,116 @@ size_t file::getSize(const std::string& filename)
     struct stat buffer;
     return stat(filename.c_str(), &buffer) == 0 ? buffer.st_size : 0;
 }
+
+uint64_t file::getStamp(const std::string& filename)
+{
+    struct stat buffer;
+    if (stat(filename.c_str(), &buffer) != 0)
+        return 0;
+
+    return (uint64_t(buffer.st_mtime) << 32) ^ uint64_t(buffer.st_size);
+}
+
+bool file::replace(const std::string& from, const std::string& to)
+{
+#if defined(_WIN32) && !defined(EMSCRIPTEN)
+    // std::rename fails on Windows if the target exists
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+bool file::MappedFile::open(const std::string& path)
+{
+    close();
+
+#if defined(EMSCRIPTEN)
+    std::ifstream input(path, std::ios::binary);
+    if (!input.is_open())
+        return false;
+
+    m_buffer.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    if (m_buffer.empty())
+        return false;
+
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+#elif defined(_WIN32)
+    HANDLE fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    HANDLE mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mappingHandle)
+    {
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    void* data = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    if (!data)
+    {
+        CloseHandle(mappingHandle);
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    m_fileHandle = fileHandle;
+    m_mappingHandle = mappingHandle;
+    m_data = static_cast<const char*>(data);
+    m_size = size_t(fileSize.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, size_t(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+
+    if (data == MAP_FAILED)
+        return false;
+
+    m_data = static_cast<const char*>(data);
+    m_size = size_t(fileStat.st_size);
+#endif
+
+    return true;
+}
+
+void file::MappedFile::close()
+{
+    if (!m_data)
+        return;
+
+#if defined(EMSCRIPTEN)
+    m_buffer.clear();
+    m_buffer.shrink_to_fit();
+#elif defined(_WIN32)
+    UnmapViewOfFile(m_data);
+    CloseHandle(m_mappingHandle);
+    CloseHandle(m_fileHandle);
+    m_mappingHandle = nullptr;
+    m_fileHandle = nullptr;
+#else
+    munmap(const_cast<char*>(m_data), m_size);
+#endif
+
+    m_data = nullptr;
+    m_size = 0;
+}
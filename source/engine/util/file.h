@@ -10,4 +10,51 @@ namespace file
 
     bool exists(const std::string& filename);
     size_t getSize(const std::string& filename);
+
+    /**
+    * Changes whenever the file is modified: the modification time (seconds) in the upper and the size in the lower
+    * 32 bits (xor'ed, so sizes above 4 GB still contribute). Returns 0 if the file doesn't exist.
+    */
+    uint64_t getStamp(const std::string& filename);
+
+    /**
+    * Renames the file from to the path to and replaces an existing file to. Returns false if that fails
+    * (e.g. on Windows while to is mapped).
+    */
+    bool replace(const std::string& from, const std::string& to);
+
+    /**
+    * Read-only memory mapping of a whole file. The pages are loaded by the OS on first access.
+    * Without mmap support (emscripten) the file is read into memory instead.
+    */
+    class MappedFile
+    {
+    public:
+        MappedFile() {}
+        ~MappedFile() { close(); }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        /**
+        * Returns false if the file doesn't exist, is empty or can't be mapped.
+        */
+        bool open(const std::string& path);
+        void close();
+
+        bool isOpen() const { return m_data != nullptr; }
+        const char* data() const { return m_data; }
+        size_t size() const { return m_size; }
+
+    private:
+        const char* m_data{ nullptr };
+        size_t m_size{ 0 };
+
+#if defined(EMSCRIPTEN)
+        std::vector<char> m_buffer;
+#elif defined(_WIN32)
+        void* m_fileHandle{ nullptr };
+        void* m_mappingHandle{ nullptr };
+#endif
+    };
 }
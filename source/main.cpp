@@ -1,5 +1,6 @@
 #include <engine/Engine.h>
 #include "app/MeshDecimationApp.h"
+#include "app/MeshTool.h"
 #include <memory>
 
 #ifdef __EMSCRIPTEN__
@@ -10,8 +11,11 @@ std::unique_ptr<Engine> engine;
 
 void onFrame();
 
-int main(int, char**)
+int main(int argc, char** argv)
 {
+    if (MeshTool::isCommand(argc, argv))
+        return MeshTool::run(argc, argv);
+
     engine = std::make_unique<Engine>();
     std::unique_ptr<MeshDecimationApp> app = std::make_unique<MeshDecimationApp>();
 